@@ -0,0 +1,61 @@
+#include "ConsoleLogger.h"
+#include "../DSP/Trace.h"
+
+#include <stdio.h>
+
+ConsoleLogger::ConsoleLogger()
+: Thread{"Console logger"}
+{
+}
+
+ConsoleLogger::~ConsoleLogger()
+{
+	stopThread(1000);
+}
+
+void ConsoleLogger::log(const char* label, float value)
+{
+	if(!entries.push({label, value}))
+	{
+		++dropped;
+	}
+}
+
+void ConsoleLogger::run()
+{
+	Trace::setThreadName("console logger");
+
+	while(!threadShouldExit())
+	{
+		drain();
+		wait(20);
+	}
+
+	drain();
+}
+
+void ConsoleLogger::drain()
+{
+	TraceScope scope("console drain");
+
+	LogEntry entry;
+	bool printed = false;
+
+	while(entries.pop(entry))
+	{
+		printf("%s: %.4f\n", entry.label, entry.value);
+		printed = true;
+	}
+
+	auto numDropped = dropped.exchange(0);
+	if(numDropped > 0)
+	{
+		printf("(%d log messages dropped)\n", numDropped);
+		printed = true;
+	}
+
+	if(printed)
+	{
+		fflush(stdout);
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "SPSCQueue.h"
+
+/*
+ * Background thread that owns stdout. Producers push a label and a value,
+ * the printf/fflush happens here so nobody time critical ever blocks on the console.
+ * Labels must be string literals (or otherwise outlive the logger).
+ */
+class ConsoleLogger : public Thread
+{
+public:
+	ConsoleLogger();
+	~ConsoleLogger();
+
+	// single producer, never blocks; drops the entry if the logger has fallen behind
+	void log(const char* label, float value);
+
+	void run() override;
+
+private:
+	void drain();
+
+	struct LogEntry
+	{
+		const char* label;
+		float value;
+	};
+
+	SPSCQueue<LogEntry, 256> entries;
+	Atomic<int> dropped;
+};
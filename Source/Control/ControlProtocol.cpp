@@ -0,0 +1,189 @@
+#include "ControlProtocol.h"
+
+#include <cstring>
+
+constexpr uint8_t ControlProtocol::syncByte;
+constexpr int ControlProtocol::maxEntries;
+constexpr int ControlProtocol::entrySize;
+constexpr int ControlProtocol::maxFrameSize;
+
+uint16_t ControlProtocol::crc(const uint8_t* data, int size)
+{
+	uint16_t crc = 0xffff;
+
+	for(int i = 0; i < size; ++i)
+	{
+		crc ^= static_cast<uint16_t>(data[i] << 8);
+
+		for(int bit = 0; bit < 8; ++bit)
+		{
+			crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+		}
+	}
+
+	return crc;
+}
+
+// little endian whatever the machine is
+static void writeFloat(float value, uint8_t* out)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+
+	for(int i = 0; i < 4; ++i)
+	{
+		out[i] = static_cast<uint8_t>(bits >> (8 * i));
+	}
+}
+
+static float readFloat(const uint8_t* in)
+{
+	uint32_t bits = 0;
+	for(int i = 0; i < 4; ++i)
+	{
+		bits |= static_cast<uint32_t>(in[i]) << (8 * i);
+	}
+
+	float value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+//==============================================================================
+ControlFrameEncoder::ControlFrameEncoder()
+: numEntries	{0}
+{
+	clear();
+}
+
+void ControlFrameEncoder::clear()
+{
+	numEntries = 0;
+	frame[0] = ControlProtocol::syncByte;
+	frame[1] = 0;
+}
+
+bool ControlFrameEncoder::add(uint8_t id, float value)
+{
+	if(numEntries == ControlProtocol::maxEntries)
+	{
+		return false;
+	}
+
+	uint8_t* entry = frame + 2 + numEntries * ControlProtocol::entrySize;
+	entry[0] = id;
+	writeFloat(value, entry + 1);
+
+	frame[1] = static_cast<uint8_t>(++numEntries);
+	return true;
+}
+
+const uint8_t* ControlFrameEncoder::getData()
+{
+	// count and entries
+	const int covered = 1 + numEntries * ControlProtocol::entrySize;
+	const uint16_t crc = ControlProtocol::crc(frame + 1, covered);
+
+	frame[1 + covered] = static_cast<uint8_t>(crc);
+	frame[2 + covered] = static_cast<uint8_t>(crc >> 8);
+
+	return frame;
+}
+
+int ControlFrameEncoder::getSize() const
+{
+	return numEntries > 0 ? 2 + numEntries * ControlProtocol::entrySize + 2 : 0;
+}
+
+//==============================================================================
+ControlFrameParser::ControlFrameParser()
+: received		{0}
+, expected		{0}
+, framed		{false}
+, resyncing		{false}
+, numEntries	{0}
+{
+}
+
+void ControlFrameParser::reset()
+{
+	huntForSync();
+	framed = false;
+	resyncing = false;
+}
+
+bool ControlFrameParser::lineIdle()
+{
+	const bool dropped = expected != 0;
+
+	huntForSync();
+	resyncing = false;
+
+	return dropped;
+}
+
+void ControlFrameParser::huntForSync()
+{
+	received = 0;
+	expected = 0;
+}
+
+ControlFrameParser::Result ControlFrameParser::feed(uint8_t byte)
+{
+	if(expected == 0)
+	{
+		if(byte != ControlProtocol::syncByte)
+		{
+			return framed || resyncing ? Result::NOISE : Result::OUTSIDE_FRAME;
+		}
+
+		// the count comes next, until then just enough to read it
+		received = 0;
+		expected = 1;
+		resyncing = true;
+		return Result::PENDING;
+	}
+
+	body[received++] = byte;
+
+	if(received == 1)
+	{
+		const int count = byte;
+		if(count < 1 || count > ControlProtocol::maxEntries)
+		{
+			huntForSync();
+			return Result::BAD_FRAME;
+		}
+
+		expected = 1 + count * ControlProtocol::entrySize + 2;
+		return Result::PENDING;
+	}
+
+	if(received < expected)
+	{
+		return Result::PENDING;
+	}
+
+	const int covered = expected - 2;
+	const uint16_t sent = static_cast<uint16_t>(body[covered] | (body[covered + 1] << 8));
+	const bool intact = sent == ControlProtocol::crc(body, covered);
+
+	huntForSync();
+
+	if(!intact)
+	{
+		return Result::BAD_FRAME;
+	}
+
+	framed = true;
+	resyncing = false;
+
+	numEntries = body[0];
+	for(int i = 0; i < numEntries; ++i)
+	{
+		const uint8_t* entry = body + 1 + i * ControlProtocol::entrySize;
+		entries[i] = { entry[0], readFloat(entry + 1) };
+	}
+
+	return Result::FRAME;
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * The binary framing the control board speaks over the serial link. A frame
+ * carries absolute values for any number of parameters at once, so a fast
+ * knob turn is one frame with the latest value instead of a click per step:
+ *
+ *     0xA5  count  { id  value } * count  crc
+ *
+ * count is 1..maxEntries, id is an FXParameterID in one byte, value a float
+ * in four bytes little endian, crc a CRC-16/CCITT (0x1021, starting at 0xffff)
+ * over count and the entries, two bytes little endian.
+ *
+ * The sync byte is outside ASCII, so the same link still takes the
+ * prototype's one character per step keys from a board that doesn't send
+ * frames. A board speaks one or the other: once a good frame has arrived,
+ * bytes outside frames are never taken as keys, so a frame that lost its
+ * sync byte or a byte in the middle can't step parameters with its payload.
+ *
+ * Nothing in here uses JUCE; ControlFrameEncoder is meant to be built into
+ * whatever sends the frames (the board, or a host that drives the pedal
+ * over USB serial) as well as the pedal itself.
+ */
+struct ControlEntry
+{
+	uint8_t id;
+	float value;
+};
+
+struct ControlProtocol
+{
+	static constexpr uint8_t syncByte = 0xa5;
+	static constexpr int maxEntries = 32;
+	static constexpr int entrySize = 5;
+	static constexpr int maxFrameSize = 2 + maxEntries * entrySize + 2;
+
+	static uint16_t crc(const uint8_t* data, int size);
+};
+
+//==============================================================================
+// host side, builds one frame
+class ControlFrameEncoder
+{
+public:
+	ControlFrameEncoder();
+
+	void clear();
+
+	// false once the frame holds maxEntries
+	bool add(uint8_t id, float value);
+
+	int getNumEntries() const
+	{
+		return numEntries;
+	}
+
+	// the finished frame, valid until the next add() or clear(); nothing to send while it's empty
+	const uint8_t* getData();
+	int getSize() const;
+
+private:
+	uint8_t frame[ControlProtocol::maxFrameSize];
+	int numEntries;
+};
+
+//==============================================================================
+/*
+ * Pedal side, takes the serial stream a byte at a time. Bytes outside a
+ * frame come back as OUTSIDE_FRAME for the caller to treat as the old keys,
+ * until the first good frame; from then on they are NOISE. A frame that
+ * fails its crc, or says it has no or too many entries, is dropped whole and
+ * the parser goes back to looking for the sync byte. Until a good frame or
+ * lineIdle(), what follows a sync byte is NOISE too, since it may be the
+ * rest of a frame that went wrong.
+ */
+class ControlFrameParser
+{
+public:
+	enum Result
+	{
+		PENDING,		// in the middle of a frame
+		FRAME,			// a good frame just ended, see getEntries()
+		OUTSIDE_FRAME,	// not part of a frame, a key
+		BAD_FRAME,		// the frame this byte ended was dropped
+		NOISE			// not part of a frame, but not to be taken as a key either
+	};
+
+	ControlFrameParser();
+
+	Result feed(uint8_t byte);
+
+	// the last good frame, until the next one
+	const ControlEntry* getEntries() const
+	{
+		return entries;
+	}
+
+	int getNumEntries() const
+	{
+		return numEntries;
+	}
+
+	/*
+	 * For the caller to say nothing has arrived for a while (longer than a
+	 * frame takes to send). A frame half way in is dropped, true if there was
+	 * one, and bytes after a failed frame can be keys again if no good frame
+	 * has come yet.
+	 */
+	bool lineIdle();
+
+	// back to the start, keys and all
+	void reset();
+
+private:
+	void huntForSync();
+
+	// count, entries and crc as they came, the crc is checked over the first two
+	uint8_t body[ControlProtocol::maxFrameSize];
+	int received;
+	int expected; // bytes after the sync byte, 0 while looking for one
+
+	bool framed;		// a good frame has arrived, no more keys
+	bool resyncing;		// a sync byte has come since the last good frame or idle line
+
+	ControlEntry entries[ControlProtocol::maxEntries];
+	int numEntries;
+};
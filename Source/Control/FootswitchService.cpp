@@ -0,0 +1,93 @@
+#include "FootswitchService.h"
+#include "../DSP/Trace.h"
+
+// wiringPi stuff
+#if defined(JUCE_LINUX) && defined(__arm__)
+#define RASPBERRY_PI 1
+extern "C" {
+#include <wiringPi.h>
+#include <mcp23008.h>
+}
+#endif
+
+static const int switchPins[FootswitchService::numSwitches] = { SWITCH1, SWITCH2, SWITCH3, SWITCH4 };
+
+FootswitchService::FootswitchService()
+: Thread		{"Footswitches"}
+, listener		{nullptr}
+, unstableMs	{0, 0, 0, 0}
+{
+	// setup raspberry pi GPIO
+	wiringPiSetup();
+
+	for(auto pin : switchPins)
+	{
+		pinMode(pin, INPUT);
+		pullUpDnControl(pin, PUD_UP);
+	}
+
+	switchMask = readSwitches();
+}
+
+FootswitchService::~FootswitchService()
+{
+	stopThread(1000);
+}
+
+uint32 FootswitchService::readSwitches() const
+{
+	uint32 mask = 0;
+
+	for(int i = 0; i < numSwitches; ++i)
+	{
+		if(digitalRead(switchPins[i]) == HIGH)
+		{
+			mask |= (1u << i);
+		}
+	}
+
+	return mask;
+}
+
+void FootswitchService::run()
+{
+	Trace::setThreadName("footswitches");
+
+	while(!threadShouldExit())
+	{
+		const uint32 published = switchMask.get();
+		const uint32 raw = readSwitches();
+		uint32 next = published;
+
+		for(int i = 0; i < numSwitches; ++i)
+		{
+			const uint32 bit = 1u << i;
+
+			if((raw & bit) == (published & bit))
+			{
+				unstableMs[i] = 0;
+				continue;
+			}
+
+			unstableMs[i] += pollIntervalMs;
+			if(unstableMs[i] >= debounceMs)
+			{
+				next ^= bit;
+				unstableMs[i] = 0;
+			}
+		}
+
+		if(next != published)
+		{
+			TraceScope scope("footswitch change");
+			switchMask = next;
+
+			if(listener != nullptr)
+			{
+				listener->footswitchesChanged(next);
+			}
+		}
+
+		wait(pollIntervalMs);
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+// switch gpio mapped to wiringPi
+#define SWITCH1 3 // OD
+#define SWITCH2 4 // Dist
+#define SWITCH3 5 // EQ
+#define SWITCH4 6 // Delay
+
+/*
+ * Polls the four footswitches on its own thread and publishes a debounced
+ * bitmask (bit n = FXStage n). A switch has to hold its new state for
+ * debounceMs before it is reported. The mask can be read from anywhere, and
+ * a listener is told about every change on the footswitch thread.
+ */
+class FootswitchService : public Thread
+{
+public:
+	class Listener
+	{
+	public:
+		virtual ~Listener() {}
+
+		// called on the footswitch thread, never the audio thread
+		virtual void footswitchesChanged(uint32 switchMask) = 0;
+	};
+
+	FootswitchService();
+	~FootswitchService();
+
+	// set before startThread()
+	void setListener(Listener* newListener)
+	{
+		listener = newListener;
+	}
+
+	static constexpr int numSwitches = 4;
+	static constexpr int pollIntervalMs = 1;
+	static constexpr int debounceMs = 5;
+
+	void run() override;
+
+	// lock-free, safe to call from the audio thread
+	uint32 getSwitchMask() const
+	{
+		return switchMask.get();
+	}
+
+private:
+	uint32 readSwitches() const;
+
+private:
+	Atomic<uint32> switchMask;
+	Listener* listener;
+
+	// how long each switch has disagreed with the published state
+	int unstableMs[numSwitches];
+};
@@ -0,0 +1,43 @@
+#include "ParameterRegistry.h"
+
+ParameterRegistry::ParameterRegistry(const FXParameters& initialParameters)
+: dirtyStages	{0}
+{
+	for(int id = 0; id < NUM_PARAMETERS; ++id)
+	{
+		auto parameter = static_cast<FXParameterID>(id);
+		values[id].store(initialParameters.get(parameter), std::memory_order_relaxed);
+	}
+}
+
+float ParameterRegistry::set(FXParameterID id, float value, bool& changed)
+{
+	const auto& info = FXParameters::getInfo(id);
+	const float clamped = jlimit(info.minimum, info.maximum, value);
+
+	changed = clamped != get(id);
+	if(changed)
+	{
+		values[id].store(clamped, std::memory_order_relaxed);
+	}
+
+	return clamped;
+}
+
+float ParameterRegistry::step(FXParameterID id, int clicks, bool& changed)
+{
+	return set(id, get(id) + clicks * FXParameters::getInfo(id).step, changed);
+}
+
+FXParameters ParameterRegistry::getParameters() const
+{
+	FXParameters parameters;
+
+	for(int id = 0; id < NUM_PARAMETERS; ++id)
+	{
+		auto parameter = static_cast<FXParameterID>(id);
+		parameters.set(parameter, get(parameter));
+	}
+
+	return parameters;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../DSP/FXParameters.h"
+
+#include <atomic>
+
+/*
+ * The live value of every parameter, shared between the control threads and
+ * the audio thread without locks. Each value is its own atomic, clamped to
+ * the range in FXParameters::getInfo(). Changes normally reach the chain as
+ * timestamped events (FXChain::scheduleParameter()); one that can't be queued
+ * is marked dirty here instead, which sets the bit of the stage that owns the
+ * parameter. The audio thread takes the dirty bits once per block and only
+ * the stages that have one set pick anything up, so turning the delay's knob
+ * never touches the waveshapers and vice versa.
+ *
+ * Values are set from one control thread (step() reads, adds and writes back);
+ * get(), getParameters() and takeDirtyStages() are fine from anywhere.
+ */
+class ParameterRegistry
+{
+public:
+	explicit ParameterRegistry(const FXParameters& initialParameters = FXParameters());
+
+	// clamped to the range; returns the value kept, false in changed if that's what it already was
+	float set(FXParameterID id, float value, bool& changed);
+
+	// clicks steps of the parameter's size, up or down
+	float step(FXParameterID id, int clicks, bool& changed);
+
+	float get(FXParameterID id) const
+	{
+		return values[id].load(std::memory_order_relaxed);
+	}
+
+	FXParameters getParameters() const;
+
+	// hands the parameter's current value to the audio thread at its next block
+	void markDirty(FXParameterID id)
+	{
+		// release, so whoever sees the bit sees the value too
+		dirtyStages.fetch_or(1u << FXParameters::getInfo(id).stage, std::memory_order_release);
+	}
+
+	// bit n set if a parameter of FXStage n changed since the last call, and clears them
+	uint32 takeDirtyStages()
+	{
+		return dirtyStages.exchange(0, std::memory_order_acquire);
+	}
+
+private:
+	std::atomic<float> values[NUM_PARAMETERS];
+	std::atomic<uint32> dirtyStages;
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+#include <array>
+
+/*
+ * Fixed size single-producer/single-consumer queue on top of AbstractFifo.
+ * push and pop never lock or allocate, so one end can live on the audio thread.
+ * Holds Capacity - 1 items.
+ */
+template <typename T, int Capacity>
+class SPSCQueue
+{
+public:
+	SPSCQueue()
+	: fifo{Capacity}
+	{}
+
+	bool push(const T& item)
+	{
+		int start1, size1, start2, size2;
+		fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+		if(size1 + size2 == 0)
+		{
+			return false;
+		}
+
+		items[size1 > 0 ? start1 : start2] = item;
+		fifo.finishedWrite(1);
+
+		return true;
+	}
+
+	bool pop(T& item)
+	{
+		int start1, size1, start2, size2;
+		fifo.prepareToRead(1, start1, size1, start2, size2);
+
+		if(size1 + size2 == 0)
+		{
+			return false;
+		}
+
+		item = items[size1 > 0 ? start1 : start2];
+		fifo.finishedRead(1);
+
+		return true;
+	}
+
+	int getNumReady() const
+	{
+		return fifo.getNumReady();
+	}
+
+private:
+	AbstractFifo fifo;
+	std::array<T, Capacity> items;
+};
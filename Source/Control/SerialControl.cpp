@@ -0,0 +1,257 @@
+#include "SerialControl.h"
+#include "../DSP/Trace.h"
+
+#include <cmath>
+#include <poll.h>
+#include <unistd.h>
+
+#if defined(JUCE_LINUX) && defined(__arm__)
+extern "C" {
+#include <wiringSerial.h>
+}
+#endif
+
+// the one character per step keys from the prototype, still understood from a board that doesn't send frames
+
+// a key that steps a parameter one click (its FXParameterInfo step) up or down
+struct StepKey
+{
+	char key;
+	FXParameterID id;
+	int clicks;
+};
+
+static const StepKey stepKeys[] = {
+	// overdrive params
+	{ 'q', FXParameterID::OD_VOL, 1 },
+	{ 'a', FXParameterID::OD_VOL, -1 },
+	{ 'w', FXParameterID::OD_BLEND, 1 },
+	{ 's', FXParameterID::OD_BLEND, -1 },
+
+	// distortion params
+	{ 'o', FXParameterID::DIST_VOL, 1 },
+	{ 'l', FXParameterID::DIST_VOL, -1 },
+	{ 'i', FXParameterID::DIST_BLEND, 1 },
+	{ 'k', FXParameterID::DIST_BLEND, -1 },
+	{ 'u', FXParameterID::DIST_TONE, 1 },
+	{ 'j', FXParameterID::DIST_TONE, -1 },
+	{ 'y', FXParameterID::DIST_DRIVE, 1 },
+	{ 'h', FXParameterID::DIST_DRIVE, -1 },
+
+	// delay params
+	{ 'e', FXParameterID::DELAY_MS, 1 },
+	{ 'd', FXParameterID::DELAY_MS, -1 },
+	{ 'r', FXParameterID::DELAY_FEEDBACK, 1 },
+	{ 'f', FXParameterID::DELAY_FEEDBACK, -1 },
+	{ 't', FXParameterID::DELAY_WET, 1 },
+	{ 'g', FXParameterID::DELAY_WET, -1 },
+
+	// eq params
+	{ 'x', FXParameterID::EQ_LOW_VOL, 1 },
+	{ 'z', FXParameterID::EQ_LOW_VOL, -1 },
+	{ 'm', FXParameterID::EQ_HIGH_VOL, 1 },
+	{ 'n', FXParameterID::EQ_HIGH_VOL, -1 }
+};
+
+// a key that picks a setting outright
+struct PresetKey
+{
+	char key;
+	FXParameterID id;
+	float value;
+};
+
+static const PresetKey presetKeys[] = {
+	{ '1', FXParameterID::EQ_LOW_FREQ, 100.0f },
+	{ '2', FXParameterID::EQ_LOW_FREQ, 200.0f },
+	{ '3', FXParameterID::EQ_LOW_FREQ, 300.0f },
+	{ '4', FXParameterID::EQ_LOW_FREQ, 400.0f },
+	{ '7', FXParameterID::EQ_HIGH_FREQ, 700.0f },
+	{ '8', FXParameterID::EQ_HIGH_FREQ, 800.0f },
+	{ '9', FXParameterID::EQ_HIGH_FREQ, 900.0f },
+	{ '0', FXParameterID::EQ_HIGH_FREQ, 1000.0f },
+	{ '-', FXParameterID::EQ_HIGH_FREQ, 2000.0f },
+	{ '=', FXParameterID::EQ_HIGH_FREQ, 3000.0f }
+};
+
+SerialControl::SerialControl(ParameterRegistry& parameterRegistry, ConsoleLogger& consoleLogger)
+: Thread		{"Serial control"}
+, registry		(parameterRegistry)
+, logger		(consoleLogger)
+, listener		{nullptr}
+, droppedFrames	{0}
+, serialPort	{-1}
+{
+}
+
+SerialControl::~SerialControl()
+{
+	stopThread(1000);
+}
+
+void SerialControl::run()
+{
+	if((serialPort = serialOpen("/dev/serial0", 9600)) < 0)
+	{
+		DBG("Error opening serial port\n");
+		return;
+	}
+
+	uint8 bytes[256];
+	Trace::setThreadName("serial");
+
+	while(!threadShouldExit())
+	{
+		if(!waitForData(50))
+		{
+			// a frame arrives in one go, so one still half way in after a quiet spell has lost bytes
+			if(parser.lineIdle())
+			{
+				logger.log("dropped serial frames", static_cast<float>(++droppedFrames));
+			}
+
+			continue;
+		}
+
+		TraceScope scope("serial batch");
+
+		// all of it, not a byte per wakeup, so nothing is left queued behind the audio thread's next block
+		bool changed = false;
+		int available;
+
+		while((available = serialDataAvail(serialPort)) > 0)
+		{
+			const auto numBytes = read(serialPort, bytes, static_cast<size_t>(jmin(available, static_cast<int>(sizeof(bytes)))));
+			if(numBytes <= 0)
+			{
+				break;
+			}
+
+			changed |= handleBytes(bytes, static_cast<int>(numBytes));
+		}
+
+		if(changed && listener != nullptr)
+		{
+			listener->parametersChanged(registry.getParameters());
+		}
+	}
+
+	serialClose(serialPort);
+	serialPort = -1;
+}
+
+bool SerialControl::waitForData(int timeoutMs)
+{
+	pollfd fd;
+	fd.fd = serialPort;
+	fd.events = POLLIN;
+	fd.revents = 0;
+
+	return poll(&fd, 1, timeoutMs) > 0 && (fd.revents & POLLIN) != 0;
+}
+
+bool SerialControl::handleBytes(const uint8* bytes, int numBytes)
+{
+	bool changed = false;
+
+	for(int i = 0; i < numBytes; ++i)
+	{
+		switch(parser.feed(bytes[i]))
+		{
+			case ControlFrameParser::Result::FRAME:
+				changed |= handleFrame();
+				break;
+
+			case ControlFrameParser::Result::OUTSIDE_FRAME:
+			{
+				FXParameterID id;
+				if(handleKey(static_cast<char>(bytes[i]), id))
+				{
+					notify(id);
+					changed = true;
+				}
+				break;
+			}
+
+			case ControlFrameParser::Result::BAD_FRAME:
+				logger.log("dropped serial frames", static_cast<float>(++droppedFrames));
+				break;
+
+			case ControlFrameParser::Result::PENDING:
+			case ControlFrameParser::Result::NOISE:
+				break;
+		}
+	}
+
+	return changed;
+}
+
+bool SerialControl::handleFrame()
+{
+	Trace::instant("serial frame");
+	bool changed = false;
+
+	for(int i = 0; i < parser.getNumEntries(); ++i)
+	{
+		const auto& entry = parser.getEntries()[i];
+
+		// ids this build doesn't know are skipped, the rest of the frame still applies
+		if(entry.id < NUM_PARAMETERS && std::isfinite(entry.value) && apply(static_cast<FXParameterID>(entry.id), entry.value))
+		{
+			changed = true;
+		}
+	}
+
+	return changed;
+}
+
+bool SerialControl::apply(FXParameterID id, float value)
+{
+	bool moved;
+	registry.set(id, value, moved);
+
+	if(moved)
+	{
+		notify(id);
+	}
+
+	return moved;
+}
+
+void SerialControl::notify(FXParameterID id)
+{
+	const float value = registry.get(id);
+	logger.log(FXParameters::getName(id), value);
+
+	if(listener != nullptr)
+	{
+		listener->parameterChanged(id, value);
+	}
+}
+
+bool SerialControl::handleKey(char data, FXParameterID& changed)
+{
+	bool moved = false;
+
+	for(const auto& binding : stepKeys)
+	{
+		if(binding.key == data)
+		{
+			registry.step(binding.id, binding.clicks, moved);
+			changed = binding.id;
+			return moved;
+		}
+	}
+
+	for(const auto& binding : presetKeys)
+	{
+		if(binding.key == data)
+		{
+			registry.set(binding.id, binding.value, moved);
+			changed = binding.id;
+			return moved;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "ConsoleLogger.h"
+#include "ControlProtocol.h"
+#include "ParameterRegistry.h"
+
+/*
+ * Control thread that owns the serial port. The control board sends frames
+ * of absolute parameter values (see ControlProtocol.h), or the prototype's
+ * single character keys that step one parameter each. Whenever anything
+ * arrives the thread reads all of it and applies every frame and key to the
+ * registry, which keeps the current values. The listener hears about each
+ * parameter as it moves and stamps it into the chain's event queue, so it
+ * lands on a sample a fixed latency later however the blocks fall; only what
+ * doesn't fit in the queue is marked dirty in the registry instead, for the
+ * audio thread to pick up at its next block. Each new value is echoed to the
+ * console logger. The audio callback never touches the port or stdout. The
+ * listener also hears about each batch of changes on this thread, for work
+ * that's too heavy for the audio thread (like designing the EQ).
+ */
+class SerialControl : public Thread
+{
+public:
+	class Listener
+	{
+	public:
+		virtual ~Listener() {}
+
+		// called on the serial thread as each parameter moves, to stamp it for the audio thread
+		virtual void parameterChanged(FXParameterID id, float value) = 0;
+
+		// called on the serial thread after every batch of changes, never the audio thread
+		virtual void parametersChanged(const FXParameters& parameters) = 0;
+	};
+
+	SerialControl(ParameterRegistry& parameterRegistry, ConsoleLogger& consoleLogger);
+	~SerialControl();
+
+	// set before startThread()
+	void setListener(Listener* newListener)
+	{
+		listener = newListener;
+	}
+
+	void run() override;
+
+private:
+	bool waitForData(int timeoutMs);
+
+	// everything read in one go, true if any parameter moved
+	bool handleBytes(const uint8* bytes, int numBytes);
+	bool handleFrame();
+
+	// true if the key moved a parameter (one already at the end of its range doesn't)
+	bool handleKey(char data, FXParameterID& changed);
+	bool apply(FXParameterID id, float value);
+
+	// logs the parameter's new value and tells the listener
+	void notify(FXParameterID id);
+
+private:
+	ParameterRegistry& registry;
+	ConsoleLogger& logger;
+	Listener* listener;
+
+	ControlFrameParser parser;
+	int droppedFrames;
+
+	int serialPort;
+};
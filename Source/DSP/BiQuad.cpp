@@ -2,116 +2,101 @@
 
 #include <cmath>
 
-BiQuad::BiQuad()
-: type{FilterType::PEAK}
-, xn_1{0}
-, xn_2{0}
-, yn_1{0}
-, yn_2{0}
-{}
-
-BiQuad::BiQuad(FilterType ftype)
-: type{ftype}
-, xn_1{0}
-, xn_2{0}
-, yn_1{0}
-, yn_2{0}
-{}
-
-BiQuad::~BiQuad()
-{}
-
 /*
  * Yet another implementation from the RBJ Audio EQ Cookbook
  * http://www.musicdsp.org/files/Audio-EQ-Cookbook.txt
  */
 
-void BiQuad::calculateCoefficients(float fs, float f0, float gain, float Q)
+BiQuadDesign BiQuadDesign::calculate(FilterType type, double fs, double f0, double gain, double Q)
 {
-	float omega = (2.0f * PI * f0) / fs;
+	double omega = (2.0 * PI * f0) / fs;
+
+	double sinomega = std::sin(omega);
+	double cosomega = std::cos(omega);
 
-	float sinomega = std::sin(omega);
-	float cosomega = std::cos(omega);
+	BiQuadDesign c = { 1, 0, 0, 0, 0 };
 
 	switch(type)
 	{
 		case FilterType::PEAK:
 		{
-			float amplitude = powf(10.0f, gain / 40.0f);
-			float peakQ = Q * amplitude;
-			float alpha = sinomega / (2.0f * peakQ);
+			double amplitude = std::pow(10.0, gain / 40.0);
+			double peakQ = Q * amplitude;
+			double alpha = sinomega / (2.0 * peakQ);
 		
 			// recipricoal of a0 coefficient to minimize division
-			float a0R = 1 / (1 + alpha/amplitude);
+			double a0R = 1 / (1 + alpha/amplitude);
 
-			b0 = (1 + alpha * amplitude) * a0R;
-			b1 = ((-2) * cosomega) * a0R;
-			b2 = (1 - alpha * amplitude) * a0R;
-			a1 = b1;
-			a2 = (1 - alpha/amplitude) * a0R;
+			c.b0 = (1 + alpha * amplitude) * a0R;
+			c.b1 = ((-2) * cosomega) * a0R;
+			c.b2 = (1 - alpha * amplitude) * a0R;
+			c.a1 = c.b1;
+			c.a2 = (1 - alpha/amplitude) * a0R;
 			
 
 			break;
 		}
 		case FilterType::LOW_PASS:
 		{
-			float alpha = sinomega / (2.0f * Q);
+			double alpha = sinomega / (2.0 * Q);
 
-			float a0R = 1 / (1 + alpha);
+			double a0R = 1 / (1 + alpha);
 
-			b0 = ((1 - cosomega) / 2) * a0R;
-			b1 = (1 - cosomega) * a0R;
-			b2 = b0;
-			a1 = (-2 * cosomega) * a0R;
-			a2 = (1 - alpha) * a0R;
+			c.b0 = ((1 - cosomega) / 2) * a0R;
+			c.b1 = (1 - cosomega) * a0R;
+			c.b2 = c.b0;
+			c.a1 = (-2 * cosomega) * a0R;
+			c.a2 = (1 - alpha) * a0R;
 
 			break;	
 		}	
 		case FilterType::HIGH_PASS:
 		{
-			float alpha = sinomega / (2.0f * Q);
+			double alpha = sinomega / (2.0 * Q);
 	
-			float a0R = 1 / (1 + alpha);
+			double a0R = 1 / (1 + alpha);
 
-			b0 = ((1 + cosomega) / 2) * a0R;
-			b1 = (-1 - cosomega) * a0R;
-			b2 = b0;
-			a1 = (-2 * cosomega) * a0R;
-			a2 = (1 - alpha) * a0R;
+			c.b0 = ((1 + cosomega) / 2) * a0R;
+			c.b1 = (-1 - cosomega) * a0R;
+			c.b2 = c.b0;
+			c.a1 = (-2 * cosomega) * a0R;
+			c.a2 = (1 - alpha) * a0R;
 
 			break;	
 		}	
-	}
-}
-
-void BiQuad::process(float* buffer, float numSamples)
-{
-	float xn, yn;
+		case FilterType::LOW_SHELF:
+		{
+			double amplitude = std::pow(10.0, gain / 40.0);
+			double alpha = sinomega / (2.0 * Q);
+			double twoRootAAlpha = 2.0 * std::sqrt(amplitude) * alpha;
 
-	for(int i = 0; i < numSamples; ++i)
-	{
-		xn = buffer[i];
-		yn = b0*xn + b1*xn_1 + b2*xn_2 - a1*yn_1 - a2*yn_2;
+			double a0R = 1 / ((amplitude + 1) + (amplitude - 1) * cosomega + twoRootAAlpha);
 
-		buffer[i] = yn;
+			c.b0 = amplitude * ((amplitude + 1) - (amplitude - 1) * cosomega + twoRootAAlpha) * a0R;
+			c.b1 = 2 * amplitude * ((amplitude - 1) - (amplitude + 1) * cosomega) * a0R;
+			c.b2 = amplitude * ((amplitude + 1) - (amplitude - 1) * cosomega - twoRootAAlpha) * a0R;
+			c.a1 = -2 * ((amplitude - 1) + (amplitude + 1) * cosomega) * a0R;
+			c.a2 = ((amplitude + 1) + (amplitude - 1) * cosomega - twoRootAAlpha) * a0R;
 
-		xn_2 = xn_1;
-		xn_1 = xn;
-		yn_2 = yn_1;
-		yn_1 = yn;	
-	}
-}
+			break;
+		}
+		case FilterType::HIGH_SHELF:
+		{
+			double amplitude = std::pow(10.0, gain / 40.0);
+			double alpha = sinomega / (2.0 * Q);
+			double twoRootAAlpha = 2.0 * std::sqrt(amplitude) * alpha;
 
-float BiQuad::process(float sampleData)
-{
-	float yn, xn = sampleData;
+			double a0R = 1 / ((amplitude + 1) - (amplitude - 1) * cosomega + twoRootAAlpha);
 
-	yn = b0*xn + b1*xn_1 + b2*xn_2 - a1*yn_1 - a2*yn_2;
+			c.b0 = amplitude * ((amplitude + 1) + (amplitude - 1) * cosomega + twoRootAAlpha) * a0R;
+			c.b1 = -2 * amplitude * ((amplitude - 1) + (amplitude + 1) * cosomega) * a0R;
+			c.b2 = amplitude * ((amplitude + 1) + (amplitude - 1) * cosomega - twoRootAAlpha) * a0R;
+			c.a1 = 2 * ((amplitude - 1) - (amplitude + 1) * cosomega) * a0R;
+			c.a2 = ((amplitude + 1) - (amplitude - 1) * cosomega - twoRootAAlpha) * a0R;
 
-	xn_2 = xn_1;
-	xn_1 = xn;
-	yn_2 = yn_1;
-	yn_1 = yn;
+			break;
+		}
+	}
 
-	return yn;
+	return c;
 }
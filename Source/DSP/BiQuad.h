@@ -1,5 +1,7 @@
 #pragma once
 
+#include "SIMD.h"
+
 #include <iostream>
 
 static constexpr double PI = 3.14159;
@@ -9,19 +11,172 @@ enum FilterType
 {
 	PEAK, // 0
 	LOW_PASS,
-	HIGH_PASS
+	HIGH_PASS,
+	LOW_SHELF,
+	HIGH_SHELF
 };
 
+/*
+ * One set of RBJ cookbook coefficients, normalised so a0 = 1. Worked out in
+ * double whatever the filter ends up running in.
+ */
+struct BiQuadDesign
+{
+	double b0, b1, b2;
+	double a1, a2;
+
+	static BiQuadDesign calculate(FilterType type, double fs, double f0, double gain, double Q);
+};
+
+// the scalar a BiQuad<T> is designed in, and how it gets spread across a T
+template <typename T>
+struct BiQuadScalar
+{
+	using Type = T;
+	static T splat(T x) { return x; }
+};
+
+template <>
+struct BiQuadScalar<Float4>
+{
+	using Type = float;
+	static Float4 splat(float x) { return Float4::splat(x); }
+};
+
+#if FX_SIMD_AVX
+template <>
+struct BiQuadScalar<Float8>
+{
+	using Type = float;
+	static Float8 splat(float x) { return Float8::splat(x); }
+};
+#endif
+
+/*
+ * A second order section in transposed direct form II: two state variables
+ * instead of DF1's four, and the input only goes through one multiply-add on
+ * its way to the output.
+ *
+ * T is float for the mono path, double where float runs out of precision
+ * (shelves and passes far below fs), or a SIMD vector from SIMD.h with one
+ * independent filter per lane (a channel each, say, or a section each as in
+ * ParametricEQ). They all run the one tick() below.
+ */
+template <typename T>
 class BiQuad
 {
 public:
-	BiQuad();
-	BiQuad(FilterType ftype); // 0 Peak, 1 Low pass, 2 High Pass, etc... (see enum)
-	~BiQuad();
+	using Scalar = typename BiQuadScalar<T>::Type;
+
+	struct Coefficients
+	{
+		T b0, b1, b2;
+		T a1, a2;
+	};
+
+	BiQuad()
+	: BiQuad(FilterType::PEAK)
+	{}
+
+	BiQuad(FilterType ftype) // 0 Peak, 1 Low pass, 2 High Pass, etc... (see enum)
+	: type			{ftype}
+	, coefficients	(passThrough())
+	, s1			(BiQuadScalar<T>::splat(0))
+	, s2			(BiQuadScalar<T>::splat(0))
+	{}
+
+	// the same design in every lane
+	void calculateCoefficients(Scalar fs, Scalar f0, Scalar gain = 0, Scalar Q = 2)
+	{
+		const auto design = BiQuadDesign::calculate(type, fs, f0, gain, Q);
+
+		setCoefficients({
+			BiQuadScalar<T>::splat(static_cast<Scalar>(design.b0)),
+			BiQuadScalar<T>::splat(static_cast<Scalar>(design.b1)),
+			BiQuadScalar<T>::splat(static_cast<Scalar>(design.b2)),
+			BiQuadScalar<T>::splat(static_cast<Scalar>(design.a1)),
+			BiQuadScalar<T>::splat(static_cast<Scalar>(design.a2))
+		});
+	}
+
+	// for lanes that each have their own design
+	void setCoefficients(const Coefficients& newCoefficients)
+	{
+		coefficients = newCoefficients;
+	}
 
-	void calculateCoefficients(float fs, float f0, float gain = 0.0f, float Q = 2.0f);
-	void process(float* buffer, float numSamples);
-	float process(float sampleData);
+	// for running the same filter elsewhere
+	const Coefficients& getCoefficients() const
+	{
+		return coefficients;
+	}
+
+	void process(T* buffer, int numSamples)
+	{
+		// locals so the compiler can keep them in registers across the loop
+		const Coefficients c = coefficients;
+		T z1 = s1, z2 = s2;
+
+		for(int i = 0; i < numSamples; ++i)
+		{
+			buffer[i] = tick(c, buffer[i], z1, z2);
+		}
+
+		s1 = z1;
+		s2 = z2;
+	}
+
+	// one sample, inline so a per-sample loop around it can keep the state in registers
+	T process(T sampleData)
+	{
+		return tick(coefficients, sampleData, s1, s2);
+	}
+
+	// the whole TDF2 recursion, for callers that keep the coefficients and state themselves
+	static T tick(const Coefficients& c, T xn, T& z1, T& z2)
+	{
+		const T yn = c.b0*xn + z1;
+
+		// yn goes in last, so sample to sample the recursion waits on two multiply-adds
+		z1 = c.b1*xn + z2 - c.a1*yn;
+		z2 = c.b2*xn - c.a2*yn;
+
+		return yn;
+	}
+
+	/*
+	 * The coefficient ramp, as ParametricEQ runs it across the block a new
+	 * design goes live in: what to add to from every sample to arrive at to
+	 * after numSamples. Every step is stable if both ends are, as the region
+	 * of stable (a1, a2) is a triangle.
+	 */
+	static Coefficients rampStep(const Coefficients& from, const Coefficients& to, int numSamples)
+	{
+		const T step = BiQuadScalar<T>::splat(static_cast<Scalar>(1) / static_cast<Scalar>(numSamples > 0 ? numSamples : 1));
+
+		return {
+			(to.b0 - from.b0) * step,
+			(to.b1 - from.b1) * step,
+			(to.b2 - from.b2) * step,
+			(to.a1 - from.a1) * step,
+			(to.a2 - from.a2) * step
+		};
+	}
+
+	static void advance(Coefficients& c, const Coefficients& step)
+	{
+		c.b0 = c.b0 + step.b0;
+		c.b1 = c.b1 + step.b1;
+		c.b2 = c.b2 + step.b2;
+		c.a1 = c.a1 + step.a1;
+		c.a2 = c.a2 + step.a2;
+	}
+
+	static Coefficients passThrough()
+	{
+		const T zero = BiQuadScalar<T>::splat(0);
+		return { BiQuadScalar<T>::splat(1), zero, zero, zero, zero };
+	}
 
 	FilterType getType()
 	{
@@ -30,7 +185,7 @@ public:
 
 	void reset()
 	{
-		xn_1 = xn_2 = yn_1 = yn_2 = 0;
+		s1 = s2 = BiQuadScalar<T>::splat(0);
 	}
 
 	void changeType(FilterType ftype)
@@ -41,11 +196,8 @@ public:
 private:
 	FilterType type;
 
-	// Filter Coefficients
-	float a1, a2;
-	float b0, b1, b2;
+	Coefficients coefficients;
 
-	// Delay 
-	float xn_1, xn_2;
-	float yn_1, yn_2;
+	// TDF2 state
+	T s1, s2;
 };
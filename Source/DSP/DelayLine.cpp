@@ -1,19 +1,22 @@
 #include "DelayLine.h"
+#include "SIMD.h"
 
 #include <algorithm>
 
 DelayLine::DelayLine()
-: delaySamples		{0}
+: feedbackAccess	{false}
+, feedbackIn		{0}
 , delayMs			{0}
-, feedback			{0}
 , feedbackPct		{0}
-, wetAmt			{0}
 , wetAmtPct			{0}
-, bufferSize		{0}
-, readIndex			{0}
+, delaySamples		{0}
+, feedback			{0}
+, wetAmt			{0}
+, delayWhole		{0}
+, delayFraction		{0}
+, numChannels		{1}
 , writeIndex		{0}
 , currentSampleRate {0}
-, feedbackAccess	{false}
 {
 }
 
@@ -45,85 +48,122 @@ void DelayLine::updateParameters(
 
 void DelayLine::resetDelay()
 {
-	if(!buffer.hasBeenCleared())
-	{
-		buffer.clear();
-	}
-
-	writeIndex = readIndex = 0;
+	buffer.clear();
+	writeIndex = 0;
 }
 
-void DelayLine::prepareBuffer(float sampleRate)
+void DelayLine::prepareBuffer(float sampleRate, int channels)
 {
-	if(currentSampleRate != sampleRate)
+	if(currentSampleRate != sampleRate || numChannels != channels)
 	{
 		currentSampleRate = sampleRate;
-		bufferSize = 2 * sampleRate;
+		numChannels = channels;
 
-
-		buffer.setSize(1, bufferSize);
+		// at least two seconds, rounded up to a power of two; a guard frame for the newer point
+		buffer.setSize(static_cast<int>(2 * sampleRate) * numChannels, numChannels);
 	}
 	
 	resetDelay();
 	cookVariables(sampleRate);
 }
 
-void DelayLine::process(float* audioBuffer, float numSamples)
+void DelayLine::process(float* audioBuffer, int numFrames)
+{
+	const float feedbackAmt = feedbackAccess ? feedbackIn : feedback;
+	processRamped(audioBuffer, numFrames, { feedbackAmt, feedbackAmt }, { wetAmt, wetAmt });
+}
+
+void DelayLine::process(float* audioBuffer, int numFrames, ParameterRamp feedbackPctRamp, ParameterRamp wetPctRamp)
 {
-	float xn, yn;
+	// an outside feedback source still wins, see setFeedback()
+	const ParameterRamp feedbackRamp = feedbackAccess
+		? ParameterRamp { feedbackIn, feedbackIn }
+		: ParameterRamp { feedbackPctRamp.start / 100.0f, feedbackPctRamp.end / 100.0f };
 
-	for(int i = 0; i < numSamples; ++i)
+	processRamped(audioBuffer, numFrames, feedbackRamp, { wetPctRamp.start / 100.0f, wetPctRamp.end / 100.0f });
+}
+
+void DelayLine::processRamped(float* audioBuffer, int numFrames, ParameterRamp feedbackRamp, ParameterRamp wetRamp)
+{
+	if(buffer.getSize() == 0)
 	{
-		xn = audioBuffer[i];
-		yn = buffer.getSample(0, readIndex);
+		return;
+	}
 
-		if(readIndex == writeIndex && delaySamples < 1.0f)
-		{
-			yn = xn;
-		}
+	// everything below counts samples, a frame is numChannels of them
+	const int numSamples = numFrames * numChannels;
 
-		int readIndex_1 = readIndex - 1;
-		if(readIndex_1 < 0)
+	int offset = 0;
+	while(offset < numSamples)
+	{
+		// taps[0] is the older of the two interpolation points, taps[numChannels] the newer one
+		const int tapIndex = writeIndex - (delayWhole + 1) * numChannels;
+
+		// a run can't be longer than the delay or it would read samples it is
+		// about to write, and neither the reads nor the writes may wrap inside it
+		int length = numSamples - offset;
+		if(delayWhole > 0)
 		{
-			readIndex_1 = bufferSize - 1;
+			length = std::min(length, delayWhole * numChannels);
 		}
+		length = buffer.getContiguous(writeIndex, length);
+		length = buffer.getContiguous(tapIndex, length);
 
-		float yn_1 = buffer.getSample(0, readIndex_1);
+		// the ring wraps on a whole frame, so runs always start on one
+		processRun(buffer.getPointer(tapIndex), buffer.getPointer(writeIndex), audioBuffer + offset, length,
+			offset / numChannels, numFrames, feedbackRamp, wetRamp);
 
-		float fractionalDelay = delaySamples - static_cast<int>(delaySamples);
-		float interp = linterp({0, yn}, {1, yn_1}, fractionalDelay);
+		buffer.updateGuard(writeIndex);
 
-		if(delaySamples == 0)
-		{
-			yn = xn;
-		}
-		else 
-		{
-			yn = interp;
-		}
-		
-		if(!feedbackAccess)
-		{
-			buffer.setSample(0, writeIndex, xn + feedback * yn);
-		}
-		else
-		{
-			buffer.setSample(0, writeIndex, xn + feedbackIn * yn);
-		}
+		writeIndex = buffer.wrap(writeIndex + length);
+		offset += length;
+	}
+}
 
-		audioBuffer[i] = wetAmt * yn + (1.0f - wetAmt) * xn;
+void DelayLine::processRun(const float* taps, float* ringOut, float* audioBuffer, int numSamples,
+	int firstFrame, int numFrames, ParameterRamp feedbackRamp, ParameterRamp wetRamp) const
+{
+	const float feedbackStep = feedbackRamp.getStep(numFrames);
+	const float wetStep = wetRamp.getStep(numFrames);
 
-		writeIndex++;
-		if(writeIndex >= bufferSize)
+	// no delay, the input goes straight through and still feeds the line
+	if(delayWhole == 0)
+	{
+		for(int i = 0; i < numSamples; ++i)
 		{
-			writeIndex = 0;
+			const float feedbackAmt = feedbackRamp.at(firstFrame + i / numChannels, feedbackStep);
+			ringOut[i] = audioBuffer[i] + feedbackAmt * audioBuffer[i];
 		}
+		return;
+	}
 
-		readIndex++;
-		if(readIndex >= bufferSize)
-		{
-			readIndex = 0;
-		}
+	const float* newerTaps = taps + numChannels;
+
+	const FloatVector fraction = FloatVector::splat(delayFraction);
+	RampVector<FloatVector> fb(feedbackRamp, numFrames, numChannels, firstFrame);
+	RampVector<FloatVector> wet(wetRamp, numFrames, numChannels, firstFrame);
+
+	int i = 0;
+	for(; i + FloatVector::size <= numSamples; i += FloatVector::size)
+	{
+		const FloatVector older = FloatVector::load(taps + i);
+		const FloatVector newer = FloatVector::load(newerTaps + i);
+		const FloatVector xn = FloatVector::load(audioBuffer + i);
+
+		const FloatVector yn = newer + fraction * (older - newer);
+
+		(xn + fb.next() * yn).store(ringOut + i);
+		(xn + wet.next() * (yn - xn)).store(audioBuffer + i);
+	}
+
+	for(; i < numSamples; ++i)
+	{
+		const int frame = firstFrame + i / numChannels;
+		const float xn = audioBuffer[i];
+		const float yn = newerTaps[i] + delayFraction * (taps[i] - newerTaps[i]);
+
+		ringOut[i] = xn + feedbackRamp.at(frame, feedbackStep) * yn;
+		audioBuffer[i] = xn + wetRamp.at(frame, wetStep) * (yn - xn);
 	}
 }
 
@@ -133,16 +173,25 @@ void DelayLine::cookVariables(float sampleRate)
 	wetAmt = wetAmtPct / 100.0f;
 	delaySamples = delayMs * (sampleRate / 1000.0f);
 
-	readIndex = writeIndex - static_cast<int>(delaySamples);
-	if(readIndex < 0)
+	// the feedback path needs at least one sample of delay, and the older
+	// interpolation point has to stay clear of the samples being written
+	if(delaySamples > 0.0f)
 	{
-		readIndex += bufferSize;
+		delaySamples = std::max(1.0f, delaySamples);
 	}
+	if(buffer.getSize() > 0)
+	{
+		delaySamples = std::min(delaySamples, static_cast<float>(buffer.getSize() / numChannels - 2));
+	}
+
+	delayWhole = static_cast<int>(delaySamples);
+	delayFraction = delaySamples - delayWhole;
 }
 
 float DelayLine::getFeedbackOut() const
 {
-	return feedback * buffer.getSample(0, readIndex);
+	// first channel only
+	return feedback * buffer.read(writeIndex - delayWhole * numChannels);
 }
 
 void DelayLine::setFeedback(float feedbackValue)
@@ -157,17 +206,3 @@ void DelayLine::setFeedbackAccessible(bool accessible)
 {
 	feedbackAccess = accessible;
 }
-
-float DelayLine::linterp(std::array<float, 2> dataPoint1, std::array<float, 2> dataPoint2, float distance)
-{
-	float denom = dataPoint2[0] - dataPoint1[0];
-	if(denom == 0)
-	{
-		return dataPoint1[1];
-	}
-
-	float fractionalPos = (distance - dataPoint1[0]) / denom;
-	float interp = fractionalPos * dataPoint2[1] + (1 - fractionalPos) * dataPoint1[1];
-
-	return interp;
-}
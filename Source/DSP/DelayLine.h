@@ -1,9 +1,14 @@
 #pragma once
 
-#include "../JuceLibraryCode/JuceHeader.h"
-
-#include <array>
+#include "RingBuffer.h"
+#include "SmoothedParameters.h"
 
+/*
+ * Fractional delay with feedback over one, two or four channels. Channels are
+ * interleaved in frames, in the audio and in the ring alike, so every channel
+ * shares one cursor and the whole block is still one flat pass: the two
+ * interpolation points are just one frame apart instead of one sample.
+ */
 class DelayLine
 {
 public:
@@ -17,8 +22,13 @@ public:
 		float sampleRate);
 
 	void resetDelay();
-	void prepareBuffer(float sampleRate);
-	void process(float* audioBuffer, float numSamples);
+	void prepareBuffer(float sampleRate, int channels = 1);
+
+	// numFrames frames of the channel count given to prepareBuffer, interleaved, in place
+	void process(float* audioBuffer, int numFrames);
+
+	// the same with feedback and wet (in percent, as updateParameters takes them) moving linearly over the block
+	void process(float* audioBuffer, int numFrames, ParameterRamp feedbackPctRamp, ParameterRamp wetPctRamp);
 	
 	void cookVariables(float sampleRate);
 
@@ -27,7 +37,11 @@ public:
 	void setFeedbackAccessible(bool accessible);
 
 private:
-	float linterp(std::array<float, 2> dataPoint1, std::array<float, 2> dataPoint2, float distance);
+	void processRamped(float* audioBuffer, int numFrames, ParameterRamp feedbackRamp, ParameterRamp wetRamp);
+
+	// firstFrame is where the run starts in the block of numFrames the ramps go across
+	void processRun(const float* taps, float* ringOut, float* audioBuffer, int numSamples,
+		int firstFrame, int numFrames, ParameterRamp feedbackRamp, ParameterRamp wetRamp) const;
 	
 private:
 	bool feedbackAccess;
@@ -41,11 +55,15 @@ private:
 	float feedback;
 	float wetAmt;
 
-	AudioSampleBuffer buffer;
-	int bufferSize;
+	// delaySamples split into the whole and fractional part
+	int delayWhole;
+	float delayFraction;
+
+	// samples per frame, the ring and writeIndex count samples, the delay counts frames
+	int numChannels;
 
+	RingBuffer buffer;
 	int writeIndex;
-	int readIndex;
 
 	int currentSampleRate;
 };
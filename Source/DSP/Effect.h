@@ -0,0 +1,57 @@
+#pragma once
+
+#include "FXParameters.h"
+
+/*
+ * What every stage in an FXChain looks like from the outside. The chain only
+ * ever talks to its stages through this, which is what lets it run them in
+ * whatever order the chain description asks for.
+ *
+ * prepare() and reset() are never called while process() is running.
+ * setParameters() and process() are both called on the audio thread.
+ *
+ * Audio comes as frames of numChannels interleaved samples, numChannels is
+ * 1, 2 or 4 and fixed by prepare(). Stateless effects can treat a block as
+ * one flat run of numFrames * numChannels samples; anything with per-channel
+ * state keeps one copy per channel, in SIMD lanes where it can.
+ */
+class Effect
+{
+public:
+	static constexpr int maxChannels = 4;
+
+	virtual ~Effect() {}
+
+	virtual void prepare(float sampleRate, int maximumBlockSize, int numChannels) = 0;
+	virtual void reset() = 0;
+
+	// in place, numFrames is never more than the maximumBlockSize given to prepare()
+	virtual void process(float* frames, int numFrames) = 0;
+
+	// each effect picks out the parameters it cares about
+	virtual void setParameters(const FXParameters& parameters) = 0;
+
+	/*
+	 * For the chain's switch crossfades, in stages whose output lags their
+	 * input: process() with the output blended back into the input where the
+	 * two still line up, the stage's share starting at mix and moving by
+	 * mixStep per frame, clamped to 0..1. False, leaving frames alone, if the
+	 * chain can blend after process() itself.
+	 */
+	virtual bool processBlended(float* /*frames*/, int /*numFrames*/, float /*mix*/, float /*mixStep*/)
+	{
+		return false;
+	}
+
+	/*
+	 * For a stage that's switched off, in place of process(). Stages whose
+	 * output lags their input run just what delays it, so the chain's latency
+	 * stays put when they're switched, and return true to stay in the plan.
+	 * False, leaving frames alone, for the rest and for a stage that doesn't
+	 * lag right now (an oversampled one at 1x); the chain drops those.
+	 */
+	virtual bool processBypassed(float* /*frames*/, int /*numFrames*/)
+	{
+		return false;
+	}
+};
@@ -0,0 +1,508 @@
+#include "Effects.h"
+#include "Waveshaper.h"
+
+#include <algorithm>
+
+/*
+ * The oversampling filters work a channel at a time, so interleaved frames are
+ * split out and put back around them. kernel(block, blockSize, frameWidth)
+ * always gets the whole chunk, as one channel or as interleaved frames.
+ *
+ * With a fade, the kernel's output is blended back into its oversampled
+ * input, so the dry share goes through the same filters as the wet one and
+ * comes out just as late; a dry copy taken before upsampling would be the
+ * filters' latency early and comb filter the fade. Only while oversampling.
+ */
+template <typename Kernel>
+static void processOversampled(Oversampler* oversamplers, float* channelBuffer, float* fadeBuffer, const OversampledFade* fade, float* frames, int numFrames, int numChannels, Kernel kernel)
+{
+	auto channelKernel = [&](float* block, int blockSize)
+	{
+		if(fade == nullptr)
+		{
+			kernel(block, blockSize, 1);
+			return;
+		}
+
+		std::copy(block, block + blockSize, fadeBuffer);
+		kernel(block, blockSize, 1);
+
+		// the same ramp as the chain's, a frame's worth of it spread over the frame's oversampled samples
+		const float step = fade->mixStep * static_cast<float>(numFrames) / static_cast<float>(blockSize);
+		float mix = fade->mix;
+
+		for(int i = 0; i < blockSize; ++i)
+		{
+			mix = std::min(1.0f, std::max(0.0f, mix + step));
+			block[i] = fadeBuffer[i] + mix * (block[i] - fadeBuffer[i]);
+		}
+	};
+
+	if(numChannels == 1)
+	{
+		oversamplers[0].process(frames, numFrames, channelKernel);
+		return;
+	}
+
+	// the waveshapers don't care how the channels are laid out, without oversampling it's one flat pass
+	if(oversamplers[0].getFactor() == 1)
+	{
+		kernel(frames, numFrames * numChannels, numChannels);
+		return;
+	}
+
+	for(int channel = 0; channel < numChannels; ++channel)
+	{
+		for(int i = 0; i < numFrames; ++i)
+		{
+			channelBuffer[i] = frames[i * numChannels + channel];
+		}
+
+		oversamplers[channel].process(channelBuffer, numFrames, channelKernel);
+
+		for(int i = 0; i < numFrames; ++i)
+		{
+			frames[i * numChannels + channel] = channelBuffer[i];
+		}
+	}
+}
+
+// only the oversampling filters, for a stage that's switched off; false without oversampling, there's nothing to delay
+static bool bypassOversampled(Oversampler* oversamplers, float* channelBuffer, float* frames, int numFrames, int numChannels)
+{
+	if(oversamplers[0].getFactor() == 1)
+	{
+		return false;
+	}
+
+	processOversampled(oversamplers, channelBuffer, nullptr, nullptr, frames, numFrames, numChannels, [](float*, int, int) {});
+	return true;
+}
+
+static void prepareOversamplers(Oversampler* oversamplers, std::vector<float>& channelBuffer, std::vector<float>& fadeBuffer, int maximumBlockSize, int numChannels)
+{
+	for(int channel = 0; channel < numChannels; ++channel)
+	{
+		oversamplers[channel].prepare(maximumBlockSize);
+	}
+
+	channelBuffer.assign(static_cast<size_t>(numChannels > 1 ? maximumBlockSize : 0), 0.0f);
+	fadeBuffer.assign(static_cast<size_t>(maximumBlockSize * Oversampler::maxFactor), 0.0f);
+}
+
+//==============================================================================
+OverdriveEffect::OverdriveEffect(const SmoothedParameters& smoothedParameters)
+: smoothed				(smoothedParameters)
+, currentNumChannels	{1}
+{
+}
+
+void OverdriveEffect::prepare(float, int maximumBlockSize, int numChannels)
+{
+	currentNumChannels = numChannels;
+	prepareOversamplers(oversamplers, channelBuffer, fadeBuffer, maximumBlockSize, numChannels);
+}
+
+void OverdriveEffect::reset()
+{
+	for(auto& oversampler : oversamplers)
+	{
+		oversampler.reset();
+	}
+}
+
+void OverdriveEffect::process(float* frames, int numFrames)
+{
+	run(frames, numFrames, nullptr);
+}
+
+bool OverdriveEffect::processBlended(float* frames, int numFrames, float mix, float mixStep)
+{
+	// without oversampling the output lines up with the input, the chain's own fade will do
+	if(oversamplers[0].getFactor() == 1)
+	{
+		return false;
+	}
+
+	const OversampledFade fade = { mix, mixStep };
+	run(frames, numFrames, &fade);
+	return true;
+}
+
+bool OverdriveEffect::processBypassed(float* frames, int numFrames)
+{
+	return bypassOversampled(oversamplers, channelBuffer.data(), frames, numFrames, currentNumChannels);
+}
+
+void OverdriveEffect::run(float* frames, int numFrames, const OversampledFade* fade)
+{
+	const ParameterRamp blend = smoothed.getRamp(FXParameterID::OD_BLEND);
+	const ParameterRamp vol = smoothed.getRamp(FXParameterID::OD_VOL);
+
+	processOversampled(oversamplers, channelBuffer.data(), fadeBuffer.data(), fade, frames, numFrames, currentNumChannels, [&](float* block, int blockSize, int frameWidth)
+	{
+		overdriveBlock(block, blockSize, blend, vol, frameWidth);
+	});
+}
+
+void OverdriveEffect::setParameters(const FXParameters&)
+{
+	// blend and vol come ramped from the chain's SmoothedParameters
+}
+
+void OverdriveEffect::setOversampling(int factor)
+{
+	for(auto& oversampler : oversamplers)
+	{
+		if(factor != oversampler.getFactor())
+		{
+			oversampler.setFactor(factor);
+		}
+	}
+}
+
+//==============================================================================
+DistortionEffect::DistortionEffect(const SmoothedParameters& smoothedParameters)
+: smoothed				(smoothedParameters)
+, currentNumChannels	{1}
+{
+}
+
+void DistortionEffect::prepare(float, int maximumBlockSize, int numChannels)
+{
+	currentNumChannels = numChannels;
+	prepareOversamplers(oversamplers, channelBuffer, fadeBuffer, maximumBlockSize, numChannels);
+}
+
+void DistortionEffect::reset()
+{
+	for(auto& oversampler : oversamplers)
+	{
+		oversampler.reset();
+	}
+}
+
+void DistortionEffect::process(float* frames, int numFrames)
+{
+	run(frames, numFrames, nullptr);
+}
+
+bool DistortionEffect::processBlended(float* frames, int numFrames, float mix, float mixStep)
+{
+	if(oversamplers[0].getFactor() == 1)
+	{
+		return false;
+	}
+
+	const OversampledFade fade = { mix, mixStep };
+	run(frames, numFrames, &fade);
+	return true;
+}
+
+bool DistortionEffect::processBypassed(float* frames, int numFrames)
+{
+	return bypassOversampled(oversamplers, channelBuffer.data(), frames, numFrames, currentNumChannels);
+}
+
+void DistortionEffect::run(float* frames, int numFrames, const OversampledFade* fade)
+{
+	const auto& shaper = driveTables.acquire();
+
+	// drive and tone only ever go in as their product, which ramps close enough to linearly over one block
+	const ParameterRamp drive = smoothed.getRamp(FXParameterID::DIST_DRIVE);
+	const ParameterRamp tone = smoothed.getRamp(FXParameterID::DIST_TONE);
+	const ParameterRamp gain = { drive.start * tone.start, drive.end * tone.end };
+	const ParameterRamp blend = smoothed.getRamp(FXParameterID::DIST_BLEND);
+	const ParameterRamp vol = smoothed.getRamp(FXParameterID::DIST_VOL);
+
+	processOversampled(oversamplers, channelBuffer.data(), fadeBuffer.data(), fade, frames, numFrames, currentNumChannels, [&](float* block, int blockSize, int frameWidth)
+	{
+		if(shaper.getCurve() == ShaperCurve::CLASSIC)
+		{
+			distortionBlock(block, blockSize, gain, blend, vol, frameWidth);
+		}
+		else
+		{
+			shaper.process(block, blockSize, gain, blend, vol, frameWidth);
+		}
+	});
+}
+
+void DistortionEffect::setParameters(const FXParameters&)
+{
+	// drive, blend, tone and vol come ramped from the chain's SmoothedParameters
+}
+
+void DistortionEffect::setOversampling(int factor)
+{
+	for(auto& oversampler : oversamplers)
+	{
+		if(factor != oversampler.getFactor())
+		{
+			oversampler.setFactor(factor);
+		}
+	}
+}
+
+void DistortionEffect::setDriveCurve(ShaperCurve curve, float shape, TableInterpolation interpolation)
+{
+	driveTables.getWriteBuffer().build(curve, shape, interpolation);
+	driveTables.publish();
+}
+
+//==============================================================================
+EQEffect::EQEffect()
+: lowVol		{0}
+, highVol		{0}
+, lowFreq		{100.0f}
+, highFreq		{1000.0f}
+, numExtraBands	{0}
+{
+	designBands(0);
+}
+
+void EQEffect::prepare(float sampleRate, int, int numChannels)
+{
+	equaliser.prepare(sampleRate, numChannels);
+}
+
+void EQEffect::reset()
+{
+	equaliser.reset();
+}
+
+void EQEffect::process(float* frames, int numFrames)
+{
+	equaliser.process(frames, numFrames);
+}
+
+void EQEffect::setParameters(const FXParameters&)
+{
+	// the EQ's parameters come in through setPeaks() on the control thread, designing on this one is what's being avoided
+}
+
+void EQEffect::setPeaks(const FXParameters& parameters, int64_t time)
+{
+	// most changes are to some other stage's knob
+	if(parameters.lowVol == lowVol && parameters.highVol == highVol && parameters.lowFreq == lowFreq && parameters.highFreq == highFreq)
+	{
+		return;
+	}
+
+	lowVol = parameters.lowVol;
+	highVol = parameters.highVol;
+	lowFreq = parameters.lowFreq;
+	highFreq = parameters.highFreq;
+
+	designBands(time);
+}
+
+bool EQEffect::setExtraBands(const EQBand* bands, int numBands)
+{
+	numExtraBands = std::min(numBands, static_cast<int>(ParametricEQ::maxBands - 2));
+	std::copy(bands, bands + numExtraBands, extraBands);
+
+	return designBands(0) && numExtraBands == numBands;
+}
+
+bool EQEffect::designBands(int64_t time)
+{
+	EQBand bands[ParametricEQ::maxBands];
+
+	// the pedal's two knob-driven peaks, Q 2 as they've always been
+	bands[0].frequency = lowFreq;
+	bands[0].gain = lowVol;
+	bands[0].Q = 2.0f;
+	bands[1].frequency = highFreq;
+	bands[1].gain = highVol;
+	bands[1].Q = 2.0f;
+
+	std::copy(extraBands, extraBands + numExtraBands, bands + 2);
+
+	return equaliser.setBands(bands, 2 + numExtraBands, time);
+}
+
+//==============================================================================
+DelayEffect::DelayEffect(const SmoothedParameters& smoothedParameters)
+: delayMS				{0}
+, feedback				{0}
+, wet					{0}
+, smoothed				(smoothedParameters)
+, currentSampleRate		{0}
+, currentNumChannels	{1}
+, runningMode			{DelayMode::ECHO}
+{
+}
+
+void DelayEffect::prepare(float sampleRate, int maximumBlockSize, int numChannels)
+{
+	currentSampleRate = sampleRate;
+	currentNumChannels = numChannels;
+
+	delayLine.updateParameters(delayMS, feedback, wet, sampleRate);
+	delayLine.prepareBuffer(sampleRate, numChannels);
+
+	for(auto& multiTap : multiTaps)
+	{
+		multiTap.prepare(sampleRate);
+		multiTap.setDryLevel(0.0f);
+	}
+
+	for(auto& modulatedDelay : modulatedDelays)
+	{
+		modulatedDelay.prepare(sampleRate);
+	}
+
+	channelBuffer.assign(static_cast<size_t>(maximumBlockSize) * 3, 0.0f);
+
+	applyVoicing(voicings.acquire());
+}
+
+void DelayEffect::reset()
+{
+	delayLine.resetDelay();
+
+	for(auto& multiTap : multiTaps)
+	{
+		multiTap.reset();
+	}
+
+	for(auto& modulatedDelay : modulatedDelays)
+	{
+		modulatedDelay.reset();
+	}
+}
+
+void DelayEffect::process(float* frames, int numFrames)
+{
+	bool changed;
+	const auto& voicing = voicings.acquire(changed);
+
+	if(changed)
+	{
+		applyVoicing(voicing);
+	}
+
+	switch(runningMode)
+	{
+		case DelayMode::ECHO:
+			delayLine.process(frames, numFrames, smoothed.getRamp(FXParameterID::DELAY_FEEDBACK), smoothed.getRamp(FXParameterID::DELAY_WET));
+			break;
+
+		case DelayMode::MULTI_TAP:
+			processMultiTap(frames, numFrames);
+			break;
+
+		case DelayMode::MODULATED:
+			processModulated(frames, numFrames);
+			break;
+	}
+}
+
+void DelayEffect::processMultiTap(float* frames, int numFrames)
+{
+	float* input = channelBuffer.data();
+	float* left = input + numFrames;
+	float* right = left + numFrames;
+
+	if(currentNumChannels == 1)
+	{
+		std::copy(frames, frames + numFrames, input);
+		multiTaps[0].process(input, numFrames);
+
+		for(int i = 0; i < numFrames; ++i)
+		{
+			frames[i] += input[i];
+		}
+
+		return;
+	}
+
+	for(int pair = 0; pair < currentNumChannels / 2; ++pair)
+	{
+		float* pairFrames = frames + pair * 2;
+
+		for(int i = 0; i < numFrames; ++i)
+		{
+			input[i] = 0.5f * (pairFrames[i * currentNumChannels] + pairFrames[i * currentNumChannels + 1]);
+		}
+
+		multiTaps[pair].process(input, left, right, numFrames);
+
+		for(int i = 0; i < numFrames; ++i)
+		{
+			pairFrames[i * currentNumChannels] += left[i];
+			pairFrames[i * currentNumChannels + 1] += right[i];
+		}
+	}
+}
+
+void DelayEffect::processModulated(float* frames, int numFrames)
+{
+	if(currentNumChannels == 1)
+	{
+		modulatedDelays[0].process(frames, numFrames);
+		return;
+	}
+
+	float* channelFrames = channelBuffer.data();
+
+	for(int channel = 0; channel < currentNumChannels; ++channel)
+	{
+		for(int i = 0; i < numFrames; ++i)
+		{
+			channelFrames[i] = frames[i * currentNumChannels + channel];
+		}
+
+		modulatedDelays[channel].process(channelFrames, numFrames);
+
+		for(int i = 0; i < numFrames; ++i)
+		{
+			frames[i * currentNumChannels + channel] = channelFrames[i];
+		}
+	}
+}
+
+void DelayEffect::setParameters(const FXParameters& parameters)
+{
+	delayMS = parameters.delayMS;
+	feedback = parameters.feedback;
+	wet = parameters.wet;
+
+	if(currentSampleRate > 0)
+	{
+		delayLine.updateParameters(delayMS, feedback, wet, currentSampleRate);
+	}
+}
+
+void DelayEffect::setVoicing(const DelayVoicing& voicing)
+{
+	voicings.getWriteBuffer() = voicing;
+	voicings.publish();
+}
+
+void DelayEffect::applyVoicing(const DelayVoicing& voicing)
+{
+	// a mode coming back in starts from silence rather than whatever it held when it went out
+	if(voicing.mode != runningMode)
+	{
+		reset();
+		runningMode = voicing.mode;
+	}
+
+	for(auto& multiTap : multiTaps)
+	{
+		for(int t = 0; t < MultiTapDelay::maxTaps; ++t)
+		{
+			multiTap.setTap(t, voicing.taps[t]);
+		}
+
+		multiTap.setNumTaps(voicing.numTaps);
+	}
+
+	for(auto& modulatedDelay : modulatedDelays)
+	{
+		modulatedDelay.setSettings(voicing.modulation);
+		modulatedDelay.setInterpolation(voicing.interpolation);
+	}
+}
@@ -0,0 +1,211 @@
+#pragma once
+
+#include "Effect.h"
+#include "BiQuad.h"
+#include "DelayLine.h"
+#include "ModulatedDelay.h"
+#include "MultiTapDelay.h"
+#include "Oversampler.h"
+#include "ParametricEQ.h"
+#include "SmoothedParameters.h"
+#include "TripleBuffer.h"
+#include "WaveshaperTable.h"
+
+#include <vector>
+
+/*
+ * The four stages of the pedal as Effects. Each one keeps its own copy of the
+ * parameters it uses; FXChain decides which of them run and in what order.
+ * The gain and mix knobs are the exception: those are read, ramped, from the
+ * chain's SmoothedParameters (indexed by FXParameterID), which the chain
+ * advances once per block before any stage runs.
+ */
+
+// a switch crossfade done at the oversampled rate, see Effect::processBlended()
+struct OversampledFade
+{
+	float mix;
+	float mixStep;
+};
+
+//==============================================================================
+class OverdriveEffect : public Effect
+{
+public:
+	explicit OverdriveEffect(const SmoothedParameters& smoothed);
+
+	void prepare(float sampleRate, int maximumBlockSize, int numChannels) override;
+	void reset() override;
+	void process(float* frames, int numFrames) override;
+	void setParameters(const FXParameters& parameters) override;
+	bool processBlended(float* frames, int numFrames, float mix, float mixStep) override;
+	bool processBypassed(float* frames, int numFrames) override;
+
+	// audio thread, between blocks
+	void setOversampling(int factor);
+	float getLatencySamples() const
+	{
+		return oversamplers[0].getLatencySamples();
+	}
+
+private:
+	// process() and processBlended(), fade is nullptr for the first
+	void run(float* frames, int numFrames, const OversampledFade* fade);
+
+	// blend and vol
+	const SmoothedParameters& smoothed;
+
+	int currentNumChannels;
+
+	// one per channel, the oversampling filters have state
+	Oversampler oversamplers[maxChannels];
+	std::vector<float> channelBuffer;
+
+	// the oversampled input while a fade blends back into it
+	std::vector<float> fadeBuffer;
+};
+
+//==============================================================================
+class DistortionEffect : public Effect
+{
+public:
+	explicit DistortionEffect(const SmoothedParameters& smoothed);
+
+	void prepare(float sampleRate, int maximumBlockSize, int numChannels) override;
+	void reset() override;
+	void process(float* frames, int numFrames) override;
+	void setParameters(const FXParameters& parameters) override;
+	bool processBlended(float* frames, int numFrames, float mix, float mixStep) override;
+	bool processBypassed(float* frames, int numFrames) override;
+
+	// audio thread, between blocks
+	void setOversampling(int factor);
+	float getLatencySamples() const
+	{
+		return oversamplers[0].getLatencySamples();
+	}
+
+	// control thread, see FXChain::setDriveCurve
+	void setDriveCurve(ShaperCurve curve, float shape, TableInterpolation interpolation);
+
+private:
+	// process() and processBlended(), fade is nullptr for the first
+	void run(float* frames, int numFrames, const OversampledFade* fade);
+
+	// drive, blend, tone and vol
+	const SmoothedParameters& smoothed;
+
+	int currentNumChannels;
+
+	TripleBuffer<WaveshaperTable> driveTables;
+
+	// one per channel, the oversampling filters have state
+	Oversampler oversamplers[maxChannels];
+	std::vector<float> channelBuffer;
+
+	// the oversampled input while a fade blends back into it
+	std::vector<float> fadeBuffer;
+};
+
+//==============================================================================
+class EQEffect : public Effect
+{
+public:
+	EQEffect();
+
+	void prepare(float sampleRate, int maximumBlockSize, int numChannels) override;
+	void reset() override;
+	void process(float* frames, int numFrames) override;
+	void setParameters(const FXParameters& parameters) override;
+
+	// control thread, see FXChain::setEQParameters and FXChain::setEQBands
+	void setPeaks(const FXParameters& parameters, int64_t time);
+	bool setExtraBands(const EQBand* bands, int numBands);
+
+	// audio thread, see ParametricEQ::takeDesigns
+	int takeDesigns(int64_t time, int numFrames)
+	{
+		return equaliser.takeDesigns(time, numFrames);
+	}
+
+private:
+	bool designBands(int64_t time);
+
+	// control side copies, the audio thread only sees the finished design
+	float lowVol, highVol;
+	float lowFreq, highFreq;
+
+	// the low and high peaks from the parameters come first, these follow them
+	EQBand extraBands[ParametricEQ::maxBands - 2];
+	int numExtraBands;
+
+	ParametricEQ equaliser;
+};
+
+//==============================================================================
+enum DelayMode
+{
+	ECHO, // 0, the DelayLine the delay knobs drive
+	MULTI_TAP,
+	MODULATED
+};
+
+/*
+ * What the delay stage runs. The modes other than ECHO play from their own
+ * settings here and leave the delay knobs alone.
+ */
+struct DelayVoicing
+{
+	DelayMode mode = DelayMode::ECHO;
+
+	// MULTI_TAP, each pair of channels is fed its mono sum and the taps are panned across the pair; the input passes at full level
+	MultiTapDelay::Tap taps[MultiTapDelay::maxTaps];
+	int numTaps = 0;
+
+	// MODULATED, chorus, flanger or vibrato on every channel separately, dry and wet as the settings have them
+	ModulatedDelay::Settings modulation;
+	ReadInterpolation interpolation = ReadInterpolation::FOUR_POINT_HERMITE;
+};
+
+class DelayEffect : public Effect
+{
+public:
+	explicit DelayEffect(const SmoothedParameters& smoothed);
+
+	void prepare(float sampleRate, int maximumBlockSize, int numChannels) override;
+	void reset() override;
+	void process(float* frames, int numFrames) override;
+	void setParameters(const FXParameters& parameters) override;
+
+	// control thread, see FXChain::setDelayVoicing
+	void setVoicing(const DelayVoicing& voicing);
+
+private:
+	void applyVoicing(const DelayVoicing& voicing);
+	void processMultiTap(float* frames, int numFrames);
+	void processModulated(float* frames, int numFrames);
+
+	float delayMS;
+	float feedback;
+	float wet;
+
+	// feedback and wet as they move, the two above are only their targets
+	const SmoothedParameters& smoothed;
+
+	float currentSampleRate;
+	int currentNumChannels;
+
+	TripleBuffer<DelayVoicing> voicings;
+	DelayMode runningMode;
+
+	DelayLine delayLine;
+
+	// one per pair of channels, or for the one channel
+	MultiTapDelay multiTaps[(maxChannels + 1) / 2];
+
+	// mono lines with their own LFO, one per channel
+	ModulatedDelay modulatedDelays[maxChannels];
+
+	// a pair's mono sum and the taps' left and right, or one channel split out for modulatedDelays
+	std::vector<float> channelBuffer;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/*
+ * Fixed size FIFO from one writer thread to one reader (the audio thread),
+ * wait-free on both sides and free of JUCE so the chain can own one. The
+ * reader can look at the oldest item before taking it, which is how the
+ * chain leaves an event that isn't due yet for a later block.
+ */
+template <typename T, int Capacity>
+class EventQueue
+{
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity has to be a power of two");
+
+public:
+	EventQueue()
+	: head{0}
+	, tail{0}
+	{}
+
+	// writer side, false if the queue is full
+	bool push(const T& item)
+	{
+		const uint32_t write = tail.load(std::memory_order_relaxed);
+
+		if(write - head.load(std::memory_order_acquire) == static_cast<uint32_t>(Capacity))
+		{
+			return false;
+		}
+
+		items[write & mask] = item;
+		tail.store(write + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	// reader side, the oldest item or nullptr if there is none; it stays put until pop()
+	const T* peek() const
+	{
+		const uint32_t read = head.load(std::memory_order_relaxed);
+		return read == tail.load(std::memory_order_acquire) ? nullptr : &items[read & mask];
+	}
+
+	void pop()
+	{
+		head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	// reader side, drops everything there is
+	void clear()
+	{
+		head.store(tail.load(std::memory_order_acquire), std::memory_order_release);
+	}
+
+private:
+	static constexpr uint32_t mask = static_cast<uint32_t>(Capacity - 1);
+
+	std::array<T, Capacity> items;
+
+	// free running counts, only ever compared by their difference
+	std::atomic<uint32_t> head;
+	std::atomic<uint32_t> tail;
+};
@@ -0,0 +1,601 @@
+#include "FXChain.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// length of the click-free crossfade when a stage is switched in or out
+static constexpr float switchFadeMs = 5.0f;
+
+// how long the gain and mix knobs take to reach a new setting, whatever the distance
+static constexpr float smoothingMs = 20.0f;
+
+// the knobs that go through SmoothedParameters, multipliers on the signal that would zipper if they jumped
+static constexpr FXParameterID smoothedParameters[] = {
+	FXParameterID::OD_BLEND, FXParameterID::OD_VOL,
+	FXParameterID::DIST_DRIVE, FXParameterID::DIST_BLEND, FXParameterID::DIST_TONE, FXParameterID::DIST_VOL,
+	FXParameterID::DELAY_FEEDBACK, FXParameterID::DELAY_WET
+};
+
+static_assert(NUM_PARAMETERS <= SmoothedParameters::maxParameters, "SmoothedParameters is indexed by FXParameterID");
+
+// callbacks start late by varying amounts, so the timeline moves this fraction of the way to each new measurement
+static constexpr double timelineTracking = 1.0 / 16.0;
+
+constexpr int FXChain::maxPendingEvents;
+constexpr int FXChain::subBlockSize;
+
+// the scratch buffers start on a cache line, a sub-block of frames is a whole number of them
+static constexpr uintptr_t scratchAlignment = 64;
+static constexpr size_t scratchSize = static_cast<size_t>(FXChain::subBlockSize * FXChain::maxChannels);
+
+static_assert((scratchSize * sizeof(float)) % scratchAlignment == 0, "a sub-block should fill whole cache lines");
+
+static int64_t nanosecondsNow()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+FXChain::FXChain()
+: planWaiting		{false}
+, sampleTime		{0}
+, timelineOrigin	{0}
+, timelineRate		{0}
+, stageMix			{0, 0, 0, 0}
+, fadeStep			{1.0f}
+, currentSampleRate	{0}
+, numChannels		{1}
+, frameWidth		{1}
+, hostBlockSize		{0}
+, frameBuffer		{nullptr}
+, dryBuffer			{nullptr}
+, overdriveEffect	{smoothed}
+, distortionEffect	{smoothed}
+, delayEffect		{smoothed}
+, effects			{&overdriveEffect, &distortionEffect, &eqEffect, &delayEffect}
+, requestedOversampling	{1}
+, appliedOversampling	{1}
+, timingEnabled		{false}
+, timingThisCall	{false}
+, tracingThisCall	{false}
+, lastTick			{0}
+, sectionsRun		{0}
+{
+	std::fill(sectionTicks, sectionTicks + StageTimings::NUM_SECTIONS, 0);
+
+	scratch.assign(2 * scratchSize + scratchAlignment / sizeof(float), 0.0f);
+
+	const auto address = reinterpret_cast<uintptr_t>(scratch.data());
+	frameBuffer = reinterpret_cast<float*>((address + scratchAlignment - 1) & ~(scratchAlignment - 1));
+	dryBuffer = frameBuffer + scratchSize;
+
+	// not prepared yet, so these land straight away rather than ramping up from zero
+	setParameters(parameters);
+
+	// everything off, but planned from the start so the oversampled stages' latency is there before the first switch
+	publishPlan(0);
+}
+
+FXChain::~FXChain()
+{
+}
+
+void FXChain::prepare(float sampleRate, int maximumBlockSize, int channels)
+{
+	currentSampleRate = sampleRate;
+	fadeStep = 1.0f / std::max(1.0f, switchFadeMs * sampleRate / 1000.0f);
+	smoothed.prepare(sampleRate, smoothingMs);
+
+	// three channels ride in four lanes, the spare one just carries silence
+	numChannels = std::max(1, std::min(channels, static_cast<int>(maxChannels)));
+	frameWidth = numChannels == 1 ? 1 : numChannels == 2 ? 2 : 4;
+
+	hostBlockSize = std::max(1, maximumBlockSize);
+
+	// stamps from the old rate or block size mean nothing any more, anchor again at the next block
+	timelineRate = 0.0f;
+	// host blocks are done in sub-blocks, so that is the largest block the effects see
+	for(auto* effect : effects)
+	{
+		effect->prepare(sampleRate, subBlockSize, frameWidth);
+	}
+
+	reset();
+}
+
+void FXChain::reset()
+{
+	for(auto* effect : effects)
+	{
+		effect->reset();
+	}
+
+	smoothed.reset();
+
+	// queued events were stamped for a timeline that has stopped, the caller hands over the current values anyway
+	events.clear();
+
+	// no point fading in from a reset, or waiting for a plan's sample, start where the newest plan says
+	runningPlan = fullPlan = plans.acquire();
+	planWaiting = false;
+
+	std::fill(stageMix, stageMix + NUM_STAGES, 0.0f);
+	for(int i = 0; i < runningPlan.numSteps; ++i)
+	{
+		stageMix[runningPlan.steps[i].stage] = runningPlan.steps[i].target;
+	}
+}
+
+void FXChain::setParameters(const FXParameters& newParameters)
+{
+	setParameters(newParameters, (1u << NUM_STAGES) - 1);
+}
+
+void FXChain::setParameters(const FXParameters& newParameters, uint32_t stages)
+{
+	parameters = newParameters;
+
+	// unchanged targets are ignored, so handing over the whole set every time is fine
+	for(auto id : smoothedParameters)
+	{
+		if((stages >> FXParameters::getInfo(id).stage) & 1u)
+		{
+			smoothed.setTarget(id, parameters.get(id));
+		}
+	}
+
+	for(int stage = 0; stage < NUM_STAGES; ++stage)
+	{
+		if((stages >> stage) & 1u)
+		{
+			effects[stage]->setParameters(parameters);
+		}
+	}
+}
+
+int64_t FXChain::getEventTime() const
+{
+	const float rate = timelineRate.load(std::memory_order_acquire);
+	if(rate <= 0.0f)
+	{
+		return 0;
+	}
+
+	const int64_t elapsed = nanosecondsNow() - timelineOrigin.load(std::memory_order_relaxed);
+	return static_cast<int64_t>(static_cast<double>(elapsed) * rate / 1.0e9);
+}
+
+bool FXChain::scheduleParameter(FXParameterID id, float value, int64_t time)
+{
+	return events.push({ time, id, value });
+}
+
+bool FXChain::setDescription(const ChainDescription& newDescription, int64_t time)
+{
+	// every stage exactly once
+	int count[NUM_STAGES] = {};
+	for(auto stage : newDescription.order)
+	{
+		if(stage < 0 || stage >= NUM_STAGES || ++count[stage] > 1)
+		{
+			return false;
+		}
+	}
+
+	description = newDescription;
+	publishPlan(time);
+
+	return true;
+}
+
+void FXChain::setStageEnabled(FXStage stage, bool enabled, int64_t time)
+{
+	if(description.enabled[stage] == enabled)
+	{
+		return;
+	}
+
+	auto newDescription = description;
+	newDescription.enabled[stage] = enabled;
+	setDescription(newDescription, time);
+}
+
+void FXChain::publishPlan(int64_t time)
+{
+	auto& plan = plans.getWriteBuffer();
+
+	// the stages that are off too, whether one is still fading out is the audio thread's to know
+	plan.numSteps = 0;
+	for(auto stage : description.order)
+	{
+		plan.steps[plan.numSteps++] = { stage, effects[stage], description.enabled[stage] ? 1.0f : 0.0f };
+	}
+
+	plan.time = time;
+	plans.publish();
+}
+
+void FXChain::process(float* const* channels, int numBuffers, int numSamples)
+{
+	numBuffers = std::min(numBuffers, numChannels);
+
+	if(hostBlockSize == 0 || numBuffers < 1)
+	{
+		return;
+	}
+
+	// on or off for the whole call, so no section is ever half timed
+	timingThisCall = timingEnabled.load(std::memory_order_relaxed);
+	const uint64_t callStart = timingThisCall ? CycleCounter::now() : 0;
+	lastTick = callStart;
+
+	// likewise for the trace, every stage's begin gets its end
+	tracingThisCall = Trace::isEnabled();
+	if(tracingThisCall)
+	{
+		Trace::begin("chain");
+	}
+
+	std::fill(sectionTicks, sectionTicks + StageTimings::NUM_SECTIONS, 0);
+	sectionsRun = 0;
+
+	int numFrames = 0;
+	updateTimeline();
+
+	// sub-blocks up to the next line of the grid, each ending early at an event or layout change due before it
+	for(int offset = 0; offset < numSamples; offset += numFrames)
+	{
+		const int toGridLine = subBlockSize - static_cast<int>(sampleTime % subBlockSize);
+		numFrames = applyDueChanges(std::min(toGridLine, numSamples - offset));
+		sampleTime += numFrames;
+
+		// one ramp per knob for the whole sub-block, every stage reads its own
+		smoothed.advance(numFrames);
+		mark(StageTimings::PARAMETERS);
+
+		if(frameWidth == 1)
+		{
+			processChunk(channels[0] + offset, numFrames);
+			continue;
+		}
+
+		float* frames = frameBuffer;
+
+		switch(frameWidth)
+		{
+			case 2: interleave<2>(channels, numBuffers, offset, frames, numFrames); break;
+			case 4: interleave<4>(channels, numBuffers, offset, frames, numFrames); break;
+		}
+
+		skip();
+		processChunk(frames, numFrames);
+
+		switch(frameWidth)
+		{
+			case 2: deinterleave<2>(frames, channels, numBuffers, offset, numFrames); break;
+			case 4: deinterleave<4>(frames, channels, numBuffers, offset, numFrames); break;
+		}
+
+		skip();
+	}
+
+	if(timingThisCall)
+	{
+		recordTimings(callStart, numSamples);
+	}
+
+	if(tracingThisCall)
+	{
+		Trace::end("chain");
+	}
+}
+
+void FXChain::process(float* buffer, int numSamples)
+{
+	float* const channels[] = { buffer };
+	process(channels, 1, numSamples);
+}
+
+void FXChain::updateTimeline()
+{
+	const double sampleRate = currentSampleRate;
+	if(sampleRate <= 0.0)
+	{
+		return;
+	}
+
+	// when getEventTime() should have read 0 going by this block: it starts now, and reads one block further on
+	const double ahead = static_cast<double>(sampleTime + hostBlockSize) * 1.0e9 / sampleRate;
+	const int64_t measured = nanosecondsNow() - static_cast<int64_t>(ahead);
+
+	if(timelineRate.load(std::memory_order_relaxed) <= 0.0f)
+	{
+		timelineOrigin.store(measured, std::memory_order_relaxed);
+		timelineRate.store(static_cast<float>(sampleRate), std::memory_order_release);
+		return;
+	}
+
+	const int64_t origin = timelineOrigin.load(std::memory_order_relaxed);
+	timelineOrigin.store(origin + static_cast<int64_t>(static_cast<double>(measured - origin) * timelineTracking), std::memory_order_relaxed);
+}
+
+int FXChain::applyDueChanges(int numFrames)
+{
+	const int factor = requestedOversampling;
+	overdriveEffect.setOversampling(factor);
+	distortionEffect.setOversampling(factor);
+
+	// the oversampled stages that are off and were dropped come back to keep their latency, the rest drop out again
+	if(factor != appliedOversampling)
+	{
+		if(appliedOversampling == 1)
+		{
+			runningPlan = fullPlan;
+		}
+
+		appliedOversampling = factor;
+	}
+
+	// parameters first, each stage that got one takes the new values once
+	uint32_t stages = 0;
+	const ParameterEvent* event;
+
+	while((event = events.peek()) != nullptr && event->time <= sampleTime)
+	{
+		parameters.set(event->id, event->value);
+		stages |= 1u << FXParameters::getInfo(event->id).stage;
+		events.pop();
+	}
+
+	if(stages != 0)
+	{
+		setParameters(parameters, stages);
+	}
+
+	if(event != nullptr)
+	{
+		numFrames = static_cast<int>(std::min<int64_t>(numFrames, event->time - sampleTime));
+	}
+
+	// so does a new EQ design
+	numFrames = eqEffect.takeDesigns(sampleTime, numFrames);
+
+	// a new plan waits here until its sample comes, the one running carries on until then
+	bool changed;
+	const auto& plan = plans.acquire(changed);
+
+	if(changed)
+	{
+		waitingPlan = plan;
+		planWaiting = true;
+	}
+
+	if(planWaiting)
+	{
+		if(waitingPlan.time <= sampleTime)
+		{
+			runningPlan = fullPlan = waitingPlan;
+			planWaiting = false;
+		}
+		else
+		{
+			numFrames = static_cast<int>(std::min<int64_t>(numFrames, waitingPlan.time - sampleTime));
+		}
+	}
+
+	return numFrames;
+}
+
+template <int FrameWidth>
+void FXChain::interleave(const float* const* channels, int numBuffers, int offset, float* frames, int numFrames)
+{
+	for(int channel = 0; channel < FrameWidth; ++channel)
+	{
+		// spare lanes, and channels the caller didn't have this time
+		if(channel >= numBuffers)
+		{
+			for(int i = 0; i < numFrames; ++i)
+			{
+				frames[i * FrameWidth + channel] = 0.0f;
+			}
+			continue;
+		}
+
+		const float* source = channels[channel] + offset;
+		for(int i = 0; i < numFrames; ++i)
+		{
+			frames[i * FrameWidth + channel] = source[i];
+		}
+	}
+}
+
+template <int FrameWidth>
+void FXChain::deinterleave(const float* frames, float* const* channels, int numBuffers, int offset, int numFrames)
+{
+	for(int channel = 0; channel < numBuffers; ++channel)
+	{
+		float* destination = channels[channel] + offset;
+		for(int i = 0; i < numFrames; ++i)
+		{
+			destination[i] = frames[i * FrameWidth + channel];
+		}
+	}
+}
+
+void FXChain::processChunk(float* frames, int numFrames)
+{
+	// steps that have finished fading out are dropped from the plan as we go
+	int kept = 0;
+	for(int i = 0; i < runningPlan.numSteps; ++i)
+	{
+		const auto& step = runningPlan.steps[i];
+
+		// a stage that's off and only passes the audio through its oversampling filters isn't timed as the stage
+		const bool bypassed = stageMix[step.stage] == step.target && step.target == 0.0f;
+		const int section = bypassed ? static_cast<int>(StageTimings::BYPASSED) : static_cast<int>(step.stage);
+
+		if(tracingThisCall)
+		{
+			Trace::begin(StageTimings::getName(section));
+		}
+
+		const bool keep = processStep(step, frames, numFrames);
+		mark(section);
+		sectionsRun |= 1u << section;
+
+		if(tracingThisCall)
+		{
+			Trace::end(StageTimings::getName(section));
+		}
+
+		if(keep)
+		{
+			runningPlan.steps[kept++] = step;
+		}
+	}
+
+	runningPlan.numSteps = kept;
+}
+
+bool FXChain::processStep(const PlanStep& step, float* frames, int numFrames)
+{
+	float mix = stageMix[step.stage];
+
+	if(mix == step.target)
+	{
+		// off and faded out, dropped from the plan unless it has to keep its latency
+		if(step.target == 0.0f)
+		{
+			return step.effect->processBypassed(frames, numFrames);
+		}
+
+		step.effect->process(frames, numFrames);
+		return true;
+	}
+
+	const float increment = step.target > mix ? fadeStep : -fadeStep;
+
+	// mid crossfade; a stage whose output lags its input blends where the two line up
+	if(step.effect->processBlended(frames, numFrames, mix, increment))
+	{
+		stageMix[step.stage] = std::min(1.0f, std::max(0.0f, mix + static_cast<float>(numFrames) * increment));
+		return true;
+	}
+
+	// otherwise run the stage and blend it with the dry copy
+	const int numSamples = numFrames * frameWidth;
+
+	float* dry = dryBuffer;
+	std::copy(frames, frames + numSamples, dry);
+
+	step.effect->process(frames, numFrames);
+
+	for(int i = 0; i < numSamples; i += frameWidth)
+	{
+		mix = std::min(1.0f, std::max(0.0f, mix + increment));
+
+		for(int channel = i; channel < i + frameWidth; ++channel)
+		{
+			frames[channel] = dry[channel] + mix * (frames[channel] - dry[channel]);
+		}
+	}
+
+	stageMix[step.stage] = mix;
+	return true;
+}
+
+void FXChain::setTimingEnabled(bool enabled)
+{
+	// measured here rather than on the audio thread the first time it reports
+	if(enabled)
+	{
+		CycleCounter::getTicksPerSecond();
+	}
+
+	timingEnabled = enabled;
+}
+
+void FXChain::recordTimings(uint64_t callStart, int numSamples)
+{
+	const uint64_t callTicks = CycleCounter::now() - callStart;
+
+	// a stage, or the bypassed ones, only count in calls they ran in
+	for(int section = 0; section < StageTimings::CHAIN; ++section)
+	{
+		if(section == StageTimings::PARAMETERS || ((sectionsRun >> section) & 1u))
+		{
+			timings[section].add(sectionTicks[section]);
+		}
+	}
+
+	timings[StageTimings::CHAIN].add(callTicks);
+
+	// longer than the block lasts: on the device this call alone would have been a dropout
+	const double budget = numSamples * CycleCounter::getTicksPerSecond() / currentSampleRate;
+	if(static_cast<double>(callTicks) > budget)
+	{
+		timings.addOverrun();
+	}
+}
+
+void FXChain::setDriveCurve(ShaperCurve curve, float shape, TableInterpolation interpolation)
+{
+	distortionEffect.setDriveCurve(curve, shape, interpolation);
+}
+
+void FXChain::setDelayVoicing(const DelayVoicing& voicing)
+{
+	delayEffect.setVoicing(voicing);
+}
+
+void FXChain::setEQParameters(const FXParameters& newParameters, int64_t time)
+{
+	eqEffect.setPeaks(newParameters, time);
+}
+
+bool FXChain::setEQBands(const EQBand* bands, int numBands)
+{
+	return eqEffect.setExtraBands(bands, numBands);
+}
+
+// per-sample reference versions of the waveshapers, the chain itself runs the block kernels in Waveshaper.h
+static constexpr float onethird = 1.0f / 3.0f;
+static constexpr float twothird = 2.0f / 3.0f;
+
+float FXChain::overdrive(float sample, float blend, float vol)
+{
+	float outSample = sample;
+
+	if(sample >= 0.0f && sample < onethird)
+	{
+		outSample *= 2.0f;
+	}
+
+	if(sample >= onethird && sample < twothird)
+	{
+		outSample = 3.0f - powf((2.0f - (3.0f * sample)), 2.0f);
+		outSample /= 3.0f;
+	}
+
+	if(sample >= twothird && sample <= 1.0f)
+	{
+		outSample = 1.0f;
+	}
+
+	outSample = (blend * outSample + (1 - blend) * sample) * vol;
+
+	return outSample;
+}
+
+float FXChain::distortion(float sample, float drive, float blend, float tone, float vol)
+{
+	float outSample;
+	float temp = sample;
+
+	temp *= drive * tone;
+
+	outSample = (((2.0f / PI ) * atan(temp) * blend) + (sample * (1.0f - blend))) * vol;
+
+	return outSample;
+}
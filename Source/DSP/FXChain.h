@@ -0,0 +1,348 @@
+#pragma once
+
+#include "FXParameters.h"
+#include "Effects.h"
+#include "EventQueue.h"
+#include "SmoothedParameters.h"
+#include "StageTimings.h"
+#include "TripleBuffer.h"
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+/*
+ * Which stages the chain runs and in what order. order holds every stage
+ * exactly once; stages that aren't enabled are left out when the chain runs.
+ */
+struct ChainDescription
+{
+	FXStage order[NUM_STAGES]	= { FXStage::OVERDRIVE, FXStage::DISTORTION, FXStage::EQ, FXStage::DELAY };
+	bool enabled[NUM_STAGES]	= { false, false, false, false };
+};
+
+/*
+ * The effect chain that used to live in MainComponent::getNextAudioBlock.
+ * No GPIO or device access happens in here, the caller decides which stages
+ * are switched on and in what order (overdrive -> distortion -> EQ -> delay
+ * unless told otherwise).
+ *
+ * Every change to the layout builds a flat execution plan on the control
+ * thread: every stage in order, each with its Effect and whether it's on. The
+ * audio thread picks the newest plan up at the next block and walks it,
+ * dropping a stage once it's off and faded out, so a bypassed stage costs
+ * nothing at all. Switching a stage on or off crossfades between its input
+ * and output over a few milliseconds instead of jumping. The exception is an
+ * oversampled stage while oversampling is on: it keeps running its
+ * oversampling filters while off so the chain's latency doesn't jump when
+ * it's switched, and turning oversampling on puts it back in the plan.
+ *
+ * Up to four channels go through one chain. They are interleaved into frames
+ * (padded to two or four wide), which the waveshapers and the delay take as
+ * one flat pass; the EQ and the oversampling filters run each channel on its
+ * own. Either way every channel is a mono channel's worth of work, so stereo
+ * costs about twice what mono does and three or four channels four times.
+ * Mono runs straight on the host buffer.
+ *
+ * The gain and mix knobs (blends, volumes, drive, tone, feedback, wet) don't
+ * jump when they're set: they ramp to the new value over a few milliseconds
+ * through one SmoothedParameters bank, see setParameters().
+ *
+ * Changes can also be stamped with the sample they should land on (see
+ * getEventTime()); the chain then splits its block right there instead of
+ * waiting for the next one, so switching and automation are sample accurate
+ * whatever the device's buffer size.
+ */
+class FXChain
+{
+public:
+	FXChain();
+	~FXChain();
+
+	static constexpr int maxChannels = Effect::maxChannels;
+
+	/*
+	 * However big the host's blocks are, the effects are handed at most
+	 * subBlockSize frames at a time, cut on a fixed grid of the chain's
+	 * timeline (an event can cut one shorter still). Their buffers, cache
+	 * footprint and the granularity of the knob ramps are then the same on
+	 * every audio interface, and for host blocks that are a multiple of
+	 * subBlockSize so is the output, to the bit.
+	 */
+	static constexpr int subBlockSize = 64;
+
+	// maximumBlockSize is what the host usually sends, only for getEventTime(); any size can be processed
+	void prepare(float sampleRate, int maximumBlockSize, int numChannels = 1);
+	void reset();
+
+	// one buffer per channel, any length; channels past the count given to prepare() are left alone, missing ones run silence
+	void process(float* const* channels, int numBuffers, int numSamples);
+
+	// mono, the first channel
+	void process(float* buffer, int numSamples);
+
+	int getNumChannels() const
+	{
+		return numChannels;
+	}
+
+	/*
+	 * Audio thread, between blocks; everything but the EQ, see setEQParameters().
+	 * The gain and mix knobs ramp from where they are to the new values over
+	 * the next smoothingMs, the delay time changes straight away.
+	 */
+	void setParameters(const FXParameters& newParameters);
+
+	// the same, but only the stages with their bit (1 << FXStage) set in stages take the new values
+	void setParameters(const FXParameters& newParameters, uint32_t stages);
+	const FXParameters& getParameters() const
+	{
+		return parameters;
+	}
+
+	/*
+	 * The chain counts every frame it processes, starting from 0 when it is
+	 * built; that count is the timeline events are stamped on. Time 0 (or
+	 * any time already gone) means as soon as possible.
+	 *
+	 * getEventTime() is now on that timeline plus one block, worked out from
+	 * when the audio thread's recent blocks started. Stamping a change with
+	 * it when it happens gives every change the same one block of latency at
+	 * the right spot inside the block, rather than however long it is until
+	 * the next callback. Any thread; 0 until the chain has processed a block.
+	 */
+	int64_t getEventTime() const;
+
+	/*
+	 * One parameter to an absolute value at the given sample, applied like
+	 * setParameters() to the stage that owns it; not the EQ's, whose changes
+	 * are stamped through setEQParameters() instead. One control thread only;
+	 * events are taken in the order they were scheduled, so one stamped
+	 * earlier than the one before it lands no earlier than that one. False
+	 * if the queue is full, say because no audio is running, in which case
+	 * hand the change over with setParameters() at a block boundary instead.
+	 * prepare() and reset() drop whatever is still queued.
+	 */
+	bool scheduleParameter(FXParameterID id, float value, int64_t time);
+
+	/*
+	 * Layout changes. Each call rebuilds the plan right here and hands it to
+	 * the audio thread, which switches to it at the given sample, so call
+	 * these from one control thread only, never from the audio callback. Only
+	 * the newest plan waits: a change made while an earlier one is still
+	 * waiting for its sample replaces it (it includes everything the earlier
+	 * one switched, at the later time). A description whose order doesn't
+	 * hold every stage exactly once is refused.
+	 */
+	bool setDescription(const ChainDescription& newDescription, int64_t time = 0);
+	const ChainDescription& getDescription() const
+	{
+		return description;
+	}
+
+	void setStageEnabled(FXStage stage, bool enabled, int64_t time = 0);
+	bool isStageEnabled(FXStage stage) const
+	{
+		return description.enabled[stage];
+	}
+
+	/*
+	 * Picks the curve the distortion stage runs. CLASSIC is the computed atan,
+	 * anything else is a lookup table built right here on the calling thread and
+	 * handed to the audio thread at the next block. Call it from one control
+	 * thread only, never from the audio callback.
+	 */
+	void setDriveCurve(ShaperCurve curve, float shape = 0.5f, TableInterpolation interpolation = TableInterpolation::CUBIC);
+
+	/*
+	 * Picks what the delay stage runs, see DelayVoicing. The audio thread
+	 * takes it at the next block; switching modes clears the delay's history.
+	 * Call it from one control thread only, never from the audio callback.
+	 */
+	void setDelayVoicing(const DelayVoicing& voicing);
+
+	/*
+	 * The EQ's knobs (lowVol, highVol, lowFreq, highFreq; the rest of
+	 * newParameters is ignored). Designing the filters costs a sin, cos and pow
+	 * per band, so it happens right here on the calling thread and the finished
+	 * coefficients go to the audio thread, which switches to them at the given
+	 * sample like a layout change: only the newest design waits. Nothing is
+	 * redesigned unless one of the four changed. Call it from one control
+	 * thread only, never from the audio callback.
+	 */
+	void setEQParameters(const FXParameters& newParameters, int64_t time = 0);
+
+	// more EQ bands after those two peaks, up to ParametricEQ::maxBands in all; same rules, false if some didn't fit
+	bool setEQBands(const EQBand* bands, int numBands);
+
+	/*
+	 * Runs the overdrive and distortion stages at 1x, 2x, 4x or 8x the device
+	 * rate to keep the harmonics they generate from folding back down. Safe to
+	 * call from any thread, it takes effect at the start of the next block.
+	 * The oversampled stages are delayed by getOversamplingLatency() samples
+	 * each, whether they're switched on or not.
+	 */
+	void setOversampling(int factor)
+	{
+		requestedOversampling = factor;
+	}
+
+	int getOversampling() const
+	{
+		return requestedOversampling;
+	}
+
+	float getOversamplingLatency() const
+	{
+		return overdriveEffect.getLatencySamples();
+	}
+
+	/*
+	 * Times every stage of every process() call into getTimings(). Off by
+	 * default, it costs a counter read per stage and sub-block. Any thread;
+	 * the first time it's switched on it measures the counter's rate, which
+	 * takes that thread ~10 ms, so not the audio one.
+	 */
+	void setTimingEnabled(bool enabled);
+
+	// any thread
+	const StageTimings& getTimings() const
+	{
+		return timings;
+	}
+
+	float overdrive(float sample, float blend, float vol);
+	float distortion(float sample, float drive, float blend, float tone, float vol);
+
+private:
+	struct PlanStep
+	{
+		FXStage stage;
+		Effect* effect;
+		float target; // 1 = switched in, 0 = off or fading out
+	};
+
+	struct ExecutionPlan
+	{
+		PlanStep steps[NUM_STAGES];
+		int numSteps = 0;
+		int64_t time = 0; // the sample it takes over on
+	};
+
+	struct ParameterEvent
+	{
+		int64_t time;
+		FXParameterID id;
+		float value;
+	};
+
+	// plenty for a few blocks' worth of knob frames, it only fills up while the audio isn't running
+	static constexpr int maxPendingEvents = 256;
+
+	void publishPlan(int64_t time);
+
+	// anchors getEventTime() to the block about to start
+	void updateTimeline();
+
+	// applies everything due at sampleTime, returns how many of numFrames can run before something else is
+	int applyDueChanges(int numFrames);
+
+	template <int FrameWidth>
+	static void interleave(const float* const* channels, int numBuffers, int offset, float* frames, int numFrames);
+	template <int FrameWidth>
+	static void deinterleave(const float* frames, float* const* channels, int numBuffers, int offset, int numFrames);
+
+	void processChunk(float* frames, int numFrames);
+	bool processStep(const PlanStep& step, float* frames, int numFrames);
+
+	// while timing, everything since the last mark or skip goes to section
+	void mark(int section)
+	{
+		if(timingThisCall)
+		{
+			const uint64_t now = CycleCounter::now();
+			sectionTicks[section] += now - lastTick;
+			lastTick = now;
+		}
+	}
+
+	// what went since the last mark only counts towards the whole call
+	void skip()
+	{
+		if(timingThisCall)
+		{
+			lastTick = CycleCounter::now();
+		}
+	}
+
+	void recordTimings(uint64_t callStart, int numSamples);
+
+private:
+	FXParameters parameters;
+
+	// declared ahead of the effects, they hold on to it
+	SmoothedParameters smoothed;
+
+	// control thread side of the layout
+	ChainDescription description;
+
+	TripleBuffer<ExecutionPlan> plans;
+
+	// audio thread side: the plan being run, all of it as it came, and the newest one if it's waiting for its sample
+	ExecutionPlan runningPlan;
+	ExecutionPlan fullPlan;
+	ExecutionPlan waitingPlan;
+	bool planWaiting;
+
+	EventQueue<ParameterEvent, maxPendingEvents> events;
+
+	// frames processed so far, the timeline events are stamped on
+	int64_t sampleTime;
+
+	// for getEventTime(): the steady_clock nanoseconds it would have read 0 at, and the sample rate (0 until anchored)
+	std::atomic<int64_t> timelineOrigin;
+	std::atomic<float> timelineRate;
+
+	// 0 = bypassed, 1 = fully in, anything between is mid crossfade
+	float stageMix[NUM_STAGES];
+	float fadeStep;
+
+	float currentSampleRate;
+
+	// channels given to prepare(), and the width of the frames the effects see (1, 2 or 4)
+	int numChannels;
+	int frameWidth;
+
+	// what prepare() was told the host's blocks are, 0 until then
+	int hostBlockSize;
+
+	// one sub-block of frames each, allocated once and lined up with cache lines
+	std::vector<float> scratch;
+
+	// the host channels interleaved, only used for more than one channel
+	float* frameBuffer;
+
+	// dry copy of the sub-block while a stage is crossfading
+	float* dryBuffer;
+
+	OverdriveEffect overdriveEffect;
+	DistortionEffect distortionEffect;
+	EQEffect eqEffect;
+	DelayEffect delayEffect;
+
+	// indexed by FXStage
+	Effect* effects[NUM_STAGES];
+
+	std::atomic<int> requestedOversampling;
+	int appliedOversampling;
+
+	StageTimings timings;
+	std::atomic<bool> timingEnabled;
+
+	// the current process() call: whether it's timed or traced, its ticks per section so far and which sections ran (1 << section)
+	bool timingThisCall;
+	bool tracingThisCall;
+	uint64_t lastTick;
+	uint64_t sectionTicks[StageTimings::NUM_SECTIONS];
+	uint32_t sectionsRun;
+};
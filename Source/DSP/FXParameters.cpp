@@ -0,0 +1,73 @@
+#include "FXParameters.h"
+
+float FXParameters::get(FXParameterID id) const
+{
+	switch(id)
+	{
+		case FXParameterID::OD_BLEND:		return odBlend;
+		case FXParameterID::OD_VOL:			return odVol;
+		case FXParameterID::DIST_DRIVE:		return distDrive;
+		case FXParameterID::DIST_BLEND:		return distBlend;
+		case FXParameterID::DIST_TONE:		return distTone;
+		case FXParameterID::DIST_VOL:		return distVol;
+		case FXParameterID::DELAY_MS:		return delayMS;
+		case FXParameterID::DELAY_FEEDBACK:	return feedback;
+		case FXParameterID::DELAY_WET:		return wet;
+		case FXParameterID::EQ_LOW_VOL:		return lowVol;
+		case FXParameterID::EQ_HIGH_VOL:	return highVol;
+		case FXParameterID::EQ_LOW_FREQ:	return lowFreq;
+		case FXParameterID::EQ_HIGH_FREQ:	return highFreq;
+		default:							return 0.0f;
+	}
+}
+
+void FXParameters::set(FXParameterID id, float value)
+{
+	switch(id)
+	{
+		case FXParameterID::OD_BLEND:		odBlend = value; break;
+		case FXParameterID::OD_VOL:			odVol = value; break;
+		case FXParameterID::DIST_DRIVE:		distDrive = value; break;
+		case FXParameterID::DIST_BLEND:		distBlend = value; break;
+		case FXParameterID::DIST_TONE:		distTone = value; break;
+		case FXParameterID::DIST_VOL:		distVol = value; break;
+		case FXParameterID::DELAY_MS:		delayMS = value; break;
+		case FXParameterID::DELAY_FEEDBACK:	feedback = value; break;
+		case FXParameterID::DELAY_WET:		wet = value; break;
+		case FXParameterID::EQ_LOW_VOL:		lowVol = value; break;
+		case FXParameterID::EQ_HIGH_VOL:	highVol = value; break;
+		case FXParameterID::EQ_LOW_FREQ:	lowFreq = value; break;
+		case FXParameterID::EQ_HIGH_FREQ:	highFreq = value; break;
+		default:							break;
+	}
+}
+
+const FXParameterInfo& FXParameters::getInfo(FXParameterID id)
+{
+	// indexed by FXParameterID
+	static const FXParameterInfo infos[NUM_PARAMETERS] = {
+		// name			min		max			step	unit	stage
+		{ "odBlend",	0.0f,	1.0f,		0.125f,	"",		FXStage::OVERDRIVE },
+		{ "odVol",		0.0f,	4.0f,		0.25f,	"",		FXStage::OVERDRIVE },
+		{ "distDrive",	0.0f,	4.0f,		0.125f,	"",		FXStage::DISTORTION },
+		{ "distBlend",	0.0f,	1.0f,		0.125f,	"",		FXStage::DISTORTION },
+		{ "distTone",	0.0f,	2000.0f,	25.0f,	"",		FXStage::DISTORTION },
+		{ "distVol",	0.0f,	4.0f,		0.25f,	"",		FXStage::DISTORTION },
+		{ "delayMS",	0.0f,	2000.0f,	100.0f,	"ms",	FXStage::DELAY },
+		{ "feedback",	0.0f,	100.0f,		1.0f,	"%",	FXStage::DELAY },
+		{ "wet",		0.0f,	100.0f,		1.0f,	"%",	FXStage::DELAY },
+		{ "lowVol",		-24.0f,	24.0f,		0.5f,	"dB",	FXStage::EQ },
+		{ "highVol",	-24.0f,	24.0f,		0.5f,	"dB",	FXStage::EQ },
+		{ "lowFreq",	20.0f,	20000.0f,	100.0f,	"Hz",	FXStage::EQ },
+		{ "highFreq",	20.0f,	20000.0f,	100.0f,	"Hz",	FXStage::EQ }
+	};
+
+	static const FXParameterInfo unknown = { "?", 0.0f, 0.0f, 0.0f, "", FXStage::NUM_STAGES };
+
+	return id >= 0 && id < NUM_PARAMETERS ? infos[id] : unknown;
+}
+
+const char* FXParameters::getName(FXParameterID id)
+{
+	return getInfo(id).name;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+enum FXStage
+{
+	OVERDRIVE, // 0
+	DISTORTION,
+	EQ,
+	DELAY,
+	NUM_STAGES
+};
+
+enum FXParameterID
+{
+	OD_BLEND, // 0
+	OD_VOL,
+	DIST_DRIVE,
+	DIST_BLEND,
+	DIST_TONE,
+	DIST_VOL,
+	DELAY_MS,
+	DELAY_FEEDBACK,
+	DELAY_WET,
+	EQ_LOW_VOL,
+	EQ_HIGH_VOL,
+	EQ_LOW_FREQ,
+	EQ_HIGH_FREQ,
+	NUM_PARAMETERS
+};
+
+/*
+ * What there is to know about one parameter, see FXParameters::getInfo().
+ * Values are kept inside [minimum, maximum]; step is one click of the
+ * control board; stage is the effect that uses it, so a change only has to
+ * reach that one.
+ */
+struct FXParameterInfo
+{
+	const char* name;
+	float minimum;
+	float maximum;
+	float step;
+	const char* unit;
+	FXStage stage;
+};
+
+/*
+ * Every knob the serial link can turn, in the units the serial controls step them in.
+ * Kept as a plain struct so the GUI app, the offline renderer and the
+ * benchmarks can all hand the same settings to an FXChain.
+ */
+struct FXParameters
+{
+	// distortion/overdrive
+	float odBlend	= 0.5f;
+	float odVol		= 1.0f;
+	float distDrive	= 0.5f;
+	float distBlend	= 0.5f;
+	float distTone	= 900.0f;
+	float distVol	= 1.0f;
+
+	// delay
+	float delayMS	= 0.0f;
+	float feedback	= 0.0f;
+	float wet		= 0.0f;
+
+	// eq
+	float lowVol	= 0.0f;
+	float highVol	= 0.0f;
+	float lowFreq	= 100.0f;
+	float highFreq	= 1000.0f;
+
+	float get(FXParameterID id) const;
+	void set(FXParameterID id, float value);
+
+	static const FXParameterInfo& getInfo(FXParameterID id);
+	static const char* getName(FXParameterID id);
+};
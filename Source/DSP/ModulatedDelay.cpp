@@ -0,0 +1,327 @@
+#include "ModulatedDelay.h"
+#include "SIMD.h"
+
+#include <algorithm>
+#include <cmath>
+
+// shortest delay the read head may reach; the four point read needs a sample
+// on either side of the position, all of them written before the current run
+static constexpr float minimumDelaySamples = 4.0f;
+
+constexpr float ModulatedDelay::maxFeedback;
+
+ModulatedDelay::Settings ModulatedDelay::Settings::chorus()
+{
+	Settings s;
+	s.delayMs = 20.0f;
+	s.depthMs = 4.0f;
+	s.rateHz = 0.8f;
+	s.feedback = 0.0f;
+	s.wet = 0.5f;
+	s.dry = 1.0f;
+	return s;
+}
+
+ModulatedDelay::Settings ModulatedDelay::Settings::flanger()
+{
+	Settings s;
+	s.delayMs = 2.5f;
+	s.depthMs = 2.0f;
+	s.rateHz = 0.25f;
+	s.feedback = 0.7f;
+	s.wet = 0.7f;
+	s.dry = 0.7f;
+	return s;
+}
+
+ModulatedDelay::Settings ModulatedDelay::Settings::vibrato()
+{
+	Settings s;
+	s.delayMs = 5.0f;
+	s.depthMs = 3.0f;
+	s.rateHz = 5.0f;
+	s.feedback = 0.0f;
+	s.wet = 1.0f;
+	s.dry = 0.0f;
+	return s;
+}
+
+ModulatedDelay::ModulatedDelay()
+: interpolation		{ReadInterpolation::FOUR_POINT_HERMITE}
+, currentSampleRate	{0}
+, centreDelay		{minimumDelaySamples}
+, depth				{0}
+, feedback			{0}
+, lfoPhase			{0}
+, lfoIncrement		{0}
+, writeIndex		{0}
+, maxRun			{1}
+{
+}
+
+void ModulatedDelay::prepare(float sampleRate, float maxDelayMs)
+{
+	currentSampleRate = sampleRate;
+
+	// three guard samples so points[0] .. points[3] are always one contiguous read
+	buffer.setSize(static_cast<int>(std::ceil(maxDelayMs * sampleRate / 1000.0f)) + 4, 3);
+
+	delays.assign(maxRunLength + FloatVector::size, 0.0f);
+	for(auto& p : points)
+	{
+		p.assign(maxRunLength, 0.0f);
+	}
+	fraction.assign(maxRunLength, 0.0f);
+
+	cookVariables();
+	reset();
+}
+
+void ModulatedDelay::reset()
+{
+	buffer.clear();
+	writeIndex = 0;
+	lfoPhase = 0.0;
+}
+
+void ModulatedDelay::setSettings(const Settings& newSettings)
+{
+	settings = newSettings;
+	cookVariables();
+}
+
+void ModulatedDelay::cookVariables()
+{
+	feedback = std::max(-maxFeedback, std::min(maxFeedback, settings.feedback));
+
+	if(currentSampleRate <= 0)
+	{
+		return;
+	}
+
+	const float samplesPerMs = currentSampleRate / 1000.0f;
+	const float longest = static_cast<float>(buffer.getSize() - 4);
+
+	depth = std::max(0.0f, settings.depthMs * samplesPerMs);
+	depth = std::min(depth, 0.5f * (longest - minimumDelaySamples));
+
+	centreDelay = settings.delayMs * samplesPerMs;
+	centreDelay = std::max(centreDelay, minimumDelaySamples + depth);
+	centreDelay = std::min(centreDelay, longest - depth);
+
+	// every read in a run has to land on samples written before the run started
+	maxRun = std::max(1, static_cast<int>(centreDelay - depth) - 2);
+	maxRun = std::min(maxRun, static_cast<int>(maxRunLength));
+
+	// at most one cycle per run keeps the phase wrap in calculateDelays to a single subtraction
+	const float maxRate = currentSampleRate / maxRunLength;
+	lfoIncrement = std::max(0.0f, std::min(settings.rateHz, maxRate)) / currentSampleRate;
+}
+
+void ModulatedDelay::process(float* audioBuffer, int numSamples)
+{
+	if(buffer.getSize() == 0)
+	{
+		return;
+	}
+
+	int offset = 0;
+	while(offset < numSamples)
+	{
+		int length = std::min(numSamples - offset, maxRun);
+		length = buffer.getContiguous(writeIndex, length);
+
+		processRun(audioBuffer + offset, length);
+
+		buffer.updateGuard(writeIndex);
+		writeIndex = buffer.wrap(writeIndex + length);
+		offset += length;
+	}
+}
+
+// sin(2 pi phase) for phase in [0, 1), to about 4e-6
+static inline FloatVector sineOfCycles(FloatVector phase)
+{
+	const FloatVector quarter = FloatVector::splat(0.25f);
+	const FloatVector half = FloatVector::splat(0.5f);
+
+	// sin(2 pi phase) = -sin(2 pi y) with y in [-0.5, 0.5), then fold y into [-0.25, 0.25]
+	FloatVector y = phase - half;
+	y = FloatVector::select(FloatVector::greaterThan(FloatVector::abs(y), quarter), FloatVector::copySign(half, y) - y, y);
+
+	const FloatVector z = FloatVector::splat(6.28318531f) * y;
+	const FloatVector z2 = z * z;
+
+	// Taylor to z^9, good enough over +-pi/2
+	FloatVector p = FloatVector::splat(1.0f / 362880.0f);
+	p = p * z2 - FloatVector::splat(1.0f / 5040.0f);
+	p = p * z2 + FloatVector::splat(1.0f / 120.0f);
+	p = p * z2 - FloatVector::splat(1.0f / 6.0f);
+	p = p * z2 + FloatVector::splat(1.0f);
+
+	return FloatVector::splat(0.0f) - p * z;
+}
+
+void ModulatedDelay::calculateDelays(int numSamples)
+{
+	float lanes[FloatVector::size];
+	for(int lane = 0; lane < FloatVector::size; ++lane)
+	{
+		lanes[lane] = static_cast<float>(lfoPhase) + lane * lfoIncrement;
+	}
+
+	FloatVector phase = FloatVector::load(lanes);
+
+	const FloatVector step = FloatVector::splat(FloatVector::size * lfoIncrement);
+	const FloatVector one = FloatVector::splat(1.0f);
+	const FloatVector centre = FloatVector::splat(centreDelay);
+	const FloatVector sweep = FloatVector::splat(depth);
+
+	// delays has room for a whole vector past any run
+	for(int i = 0; i < numSamples; i += FloatVector::size)
+	{
+		phase = FloatVector::select(FloatVector::greaterOrEqual(phase, one), phase - one, phase);
+		(centre + sweep * sineOfCycles(phase)).store(delays.data() + i);
+		phase = phase + step;
+	}
+
+	lfoPhase += numSamples * static_cast<double>(lfoIncrement);
+	lfoPhase -= std::floor(lfoPhase);
+}
+
+void ModulatedDelay::processRun(float* audioBuffer, int numSamples)
+{
+	calculateDelays(numSamples);
+
+	// read positions and the gather of the four points around each one; all
+	// locals, so the stores into the scratch arrays can't make the compiler reload them
+	const float* ring = buffer.getPointer(0);
+	const int mask = buffer.getSize() - 1;
+	const int start = writeIndex - 1;
+
+	const float* delay = delays.data();
+	float* t = fraction.data();
+	float* p0 = points[0].data();
+	float* p1 = points[1].data();
+	float* p2 = points[2].data();
+	float* p3 = points[3].data();
+
+	for(int i = 0; i < numSamples; ++i)
+	{
+		// relative to writeIndex, always negative, so the truncation needs nudging down to a floor
+		const float readPosition = static_cast<float>(i) - delay[i];
+		int whole = static_cast<int>(readPosition);
+		whole -= static_cast<float>(whole) > readPosition ? 1 : 0;
+		t[i] = readPosition - static_cast<float>(whole);
+
+		const float* p = ring + ((start + whole) & mask);
+		p0[i] = p[0];
+		p1[i] = p[1];
+		p2[i] = p[2];
+		p3[i] = p[3];
+	}
+
+	float* ringOut = buffer.getPointer(writeIndex);
+
+	switch(interpolation)
+	{
+		case ReadInterpolation::TWO_POINT_LINEAR:
+			interpolateAndMix<ReadInterpolation::TWO_POINT_LINEAR>(audioBuffer, ringOut, numSamples);
+			break;
+		case ReadInterpolation::FOUR_POINT_LAGRANGE:
+			interpolateAndMix<ReadInterpolation::FOUR_POINT_LAGRANGE>(audioBuffer, ringOut, numSamples);
+			break;
+		case ReadInterpolation::FOUR_POINT_HERMITE:
+		default:
+			interpolateAndMix<ReadInterpolation::FOUR_POINT_HERMITE>(audioBuffer, ringOut, numSamples);
+			break;
+	}
+}
+
+template <typename T>
+static inline T constant(float x);
+
+template <>
+inline float constant<float>(float x)
+{
+	return x;
+}
+
+template <>
+inline FloatVector constant<FloatVector>(float x)
+{
+	return FloatVector::splat(x);
+}
+
+// ym1, y0, y1, y2 are the samples at whole - 1 .. whole + 2, t is the fraction from y0 towards y1
+template <ReadInterpolation Interpolation, typename T>
+static inline T interpolate(T ym1, T y0, T y1, T y2, T t)
+{
+	if(Interpolation == ReadInterpolation::TWO_POINT_LINEAR)
+	{
+		return y0 + t * (y1 - y0);
+	}
+	else if(Interpolation == ReadInterpolation::FOUR_POINT_HERMITE)
+	{
+		// Catmull-Rom
+		const T c1 = constant<T>(0.5f) * (y1 - ym1);
+		const T c2 = ym1 - constant<T>(2.5f) * y0 + constant<T>(2.0f) * y1 - constant<T>(0.5f) * y2;
+		const T c3 = constant<T>(0.5f) * (y2 - ym1) + constant<T>(1.5f) * (y0 - y1);
+
+		return ((c3 * t + c2) * t + c1) * t + y0;
+	}
+	else
+	{
+		// third order Lagrange through -1, 0, 1, 2
+		const T one = constant<T>(1.0f);
+		const T tp1 = t + one;
+		const T tm1 = t - one;
+		const T tm2 = t - constant<T>(2.0f);
+
+		const T a = tm1 * tm2;
+		const T b = tp1 * t;
+
+		return constant<T>(1.0f / 6.0f) * (b * tm1 * y2 - t * a * ym1)
+			+ constant<T>(0.5f) * (tp1 * a * y0 - b * tm2 * y1);
+	}
+}
+
+template <ReadInterpolation Interpolation>
+void ModulatedDelay::interpolateAndMix(float* audioBuffer, float* ringOut, int numSamples)
+{
+	const float* p0 = points[0].data();
+	const float* p1 = points[1].data();
+	const float* p2 = points[2].data();
+	const float* p3 = points[3].data();
+	const float* t = fraction.data();
+
+	const FloatVector fb = FloatVector::splat(feedback);
+	const FloatVector wet = FloatVector::splat(settings.wet);
+	const FloatVector dry = FloatVector::splat(settings.dry);
+
+	int i = 0;
+	for(; i + FloatVector::size <= numSamples; i += FloatVector::size)
+	{
+		const FloatVector yn = interpolate<Interpolation>(
+			FloatVector::load(p0 + i),
+			FloatVector::load(p1 + i),
+			FloatVector::load(p2 + i),
+			FloatVector::load(p3 + i),
+			FloatVector::load(t + i)
+		);
+
+		const FloatVector xn = FloatVector::load(audioBuffer + i);
+
+		(xn + fb * yn).store(ringOut + i);
+		(dry * xn + wet * yn).store(audioBuffer + i);
+	}
+
+	for(; i < numSamples; ++i)
+	{
+		const float yn = interpolate<Interpolation>(p0[i], p1[i], p2[i], p3[i], t[i]);
+		const float xn = audioBuffer[i];
+
+		ringOut[i] = xn + feedback * yn;
+		audioBuffer[i] = settings.dry * xn + settings.wet * yn;
+	}
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "RingBuffer.h"
+
+#include <vector>
+
+enum ReadInterpolation
+{
+	TWO_POINT_LINEAR, // 0
+	FOUR_POINT_HERMITE,
+	FOUR_POINT_LAGRANGE
+};
+
+/*
+ * A short delay whose read head is swept by a sine LFO every sample: chorus,
+ * flanger or vibrato depending on the settings. Runs on the same RingBuffer
+ * as DelayLine, with three guard samples so a four point read never wraps.
+ *
+ * Each run is done in passes over the whole run rather than sample by
+ * sample: the LFO (a polynomial sine, a FloatVector at a time), then the read
+ * positions and a gather of the four points around each, then the
+ * interpolation and mix as a FloatVector loop, with the interpolator picked
+ * once per run rather than per sample.
+ */
+class ModulatedDelay
+{
+public:
+	struct Settings
+	{
+		float delayMs	= 7.0f;	// centre of the sweep
+		float depthMs	= 2.0f;	// sweep is delayMs +- depthMs
+		float rateHz	= 0.5f;
+		float feedback	= 0.0f;	// linear, negative flips the flanger comb; held to +-maxFeedback
+		float wet		= 0.5f;
+		float dry		= 1.0f;
+
+		static Settings chorus();
+		static Settings flanger();
+		static Settings vibrato();
+	};
+
+	static constexpr float maxFeedback = 0.98f;
+
+	ModulatedDelay();
+
+	void prepare(float sampleRate, float maxDelayMs = 50.0f);
+	void reset();
+
+	void setSettings(const Settings& newSettings);
+	const Settings& getSettings() const
+	{
+		return settings;
+	}
+
+	void setInterpolation(ReadInterpolation newInterpolation)
+	{
+		interpolation = newInterpolation;
+	}
+
+	ReadInterpolation getInterpolation() const
+	{
+		return interpolation;
+	}
+
+	void process(float* audioBuffer, int numSamples);
+
+private:
+	void cookVariables();
+	void processRun(float* audioBuffer, int numSamples);
+	void calculateDelays(int numSamples);
+
+	template <ReadInterpolation Interpolation>
+	void interpolateAndMix(float* audioBuffer, float* ringOut, int numSamples);
+
+private:
+	Settings settings;
+	ReadInterpolation interpolation;
+
+	float currentSampleRate;
+
+	// cooked, in samples
+	float centreDelay;
+	float depth;
+	float feedback;
+
+	// LFO phase and step in cycles, the sine itself is a polynomial evaluated a vector at a time
+	double lfoPhase;
+	float lfoIncrement;
+
+	RingBuffer buffer;
+	int writeIndex;
+
+	// longest run that keeps every read behind the write; runs are also capped at maxRunLength
+	int maxRun;
+	static constexpr int maxRunLength = 256;
+
+	// per-run scratch: the delay for each sample, the four points around each
+	// read and the fraction between points[1] and points[2]
+	std::vector<float> delays;
+	std::vector<float> points[4];
+	std::vector<float> fraction;
+};
@@ -0,0 +1,235 @@
+#include "MultiTapDelay.h"
+#include "SIMD.h"
+
+#include <algorithm>
+#include <cmath>
+
+constexpr int MultiTapDelay::maxTaps;
+constexpr float MultiTapDelay::maxTotalFeedback;
+
+MultiTapDelay::MultiTapDelay()
+: numTaps			{0}
+, dryLevel			{1.0f}
+, currentSampleRate	{0}
+, writeIndex		{0}
+{
+	for(auto& tap : taps)
+	{
+		cookTap(tap);
+	}
+
+	cookFeedback();
+}
+
+void MultiTapDelay::prepare(float sampleRate, float maxDelayMs)
+{
+	currentSampleRate = sampleRate;
+
+	// two extra samples for the interpolation point and the sample being written
+	buffer.setSize(static_cast<int>(std::ceil(maxDelayMs * sampleRate / 1000.0f)) + 2);
+
+	for(auto& tap : taps)
+	{
+		cookTap(tap);
+	}
+
+	reset();
+}
+
+void MultiTapDelay::reset()
+{
+	buffer.clear();
+	writeIndex = 0;
+}
+
+void MultiTapDelay::setNumTaps(int newNumTaps)
+{
+	numTaps = std::max(0, std::min(maxTaps, newNumTaps));
+	cookFeedback();
+}
+
+void MultiTapDelay::setTap(int index, const Tap& tap)
+{
+	if(index < 0 || index >= maxTaps)
+	{
+		return;
+	}
+
+	taps[index].settings = tap;
+	cookTap(taps[index]);
+	cookFeedback();
+}
+
+void MultiTapDelay::cookTap(CookedTap& tap)
+{
+	float delaySamples = tap.settings.delayMs * (currentSampleRate / 1000.0f);
+
+	// same limits as DelayLine: at least one sample for the feedback path, and
+	// the older interpolation point must stay clear of the write
+	delaySamples = std::max(1.0f, delaySamples);
+	if(buffer.getSize() > 0)
+	{
+		delaySamples = std::min(delaySamples, static_cast<float>(buffer.getSize() - 2));
+	}
+
+	tap.delayWhole = static_cast<int>(delaySamples);
+	tap.delayFraction = delaySamples - tap.delayWhole;
+
+	const float pan = std::max(-1.0f, std::min(1.0f, tap.settings.pan));
+	const float angle = (pan + 1.0f) * 0.25f * 3.14159265f;
+	tap.gainLeft = tap.settings.gain * std::cos(angle);
+	tap.gainRight = tap.settings.gain * std::sin(angle);
+}
+
+void MultiTapDelay::cookFeedback()
+{
+	// each tap reads at most the loudest sample in the ring, so with the sends' sizes adding up below 1 the echoes always die away
+	float total = 0.0f;
+	for(int t = 0; t < numTaps; ++t)
+	{
+		total += std::abs(taps[t].settings.feedback);
+	}
+
+	const float scale = total > maxTotalFeedback ? maxTotalFeedback / total : 1.0f;
+
+	for(auto& tap : taps)
+	{
+		tap.feedback = tap.settings.feedback * scale;
+	}
+}
+
+int MultiTapDelay::getShortestDelay() const
+{
+	int shortest = buffer.getSize();
+	for(int t = 0; t < numTaps; ++t)
+	{
+		shortest = std::min(shortest, taps[t].delayWhole);
+	}
+
+	return shortest;
+}
+
+void MultiTapDelay::process(float* audioBuffer, int numSamples)
+{
+	processBlock<false>(audioBuffer, audioBuffer, nullptr, numSamples);
+}
+
+void MultiTapDelay::process(const float* input, float* left, float* right, int numSamples)
+{
+	processBlock<true>(input, left, right, numSamples);
+}
+
+template <bool stereo>
+void MultiTapDelay::processBlock(const float* input, float* left, float* right, int numSamples)
+{
+	if(buffer.getSize() == 0)
+	{
+		return;
+	}
+
+	const int shortestDelay = getShortestDelay();
+	const float* tapReads[maxTaps];
+
+	int offset = 0;
+	while(offset < numSamples)
+	{
+		// no run may outlast the shortest tap, and no read or write may wrap inside one
+		int length = std::min(numSamples - offset, shortestDelay);
+		length = buffer.getContiguous(writeIndex, length);
+
+		for(int t = 0; t < numTaps; ++t)
+		{
+			const int tapIndex = writeIndex - taps[t].delayWhole - 1;
+			length = buffer.getContiguous(tapIndex, length);
+			tapReads[t] = buffer.getPointer(tapIndex);
+		}
+
+		processRun<stereo>(
+			input + offset,
+			left + offset,
+			stereo ? right + offset : nullptr,
+			buffer.getPointer(writeIndex),
+			tapReads,
+			length
+		);
+
+		buffer.updateGuard(writeIndex);
+
+		writeIndex = buffer.wrap(writeIndex + length);
+		offset += length;
+	}
+}
+
+template <bool stereo>
+void MultiTapDelay::processRun(const float* input, float* left, float* right, float* ringOut, const float* const* tapReads, int numSamples)
+{
+	const FloatVector dry = FloatVector::splat(dryLevel);
+
+	int i = 0;
+	for(; i + FloatVector::size <= numSamples; i += FloatVector::size)
+	{
+		const FloatVector xn = FloatVector::load(input + i);
+
+		FloatVector sumLeft = FloatVector::splat(0.0f);
+		FloatVector sumRight = FloatVector::splat(0.0f);
+		FloatVector sumFeedback = FloatVector::splat(0.0f);
+
+		for(int t = 0; t < numTaps; ++t)
+		{
+			const auto& tap = taps[t];
+			const float* reads = tapReads[t] + i;
+
+			const FloatVector older = FloatVector::load(reads);
+			const FloatVector newer = FloatVector::load(reads + 1);
+			const FloatVector yn = newer + FloatVector::splat(tap.delayFraction) * (older - newer);
+
+			sumFeedback = sumFeedback + FloatVector::splat(tap.feedback) * yn;
+
+			if(stereo)
+			{
+				sumLeft = sumLeft + FloatVector::splat(tap.gainLeft) * yn;
+				sumRight = sumRight + FloatVector::splat(tap.gainRight) * yn;
+			}
+			else
+			{
+				sumLeft = sumLeft + FloatVector::splat(tap.settings.gain) * yn;
+			}
+		}
+
+		(xn + sumFeedback).store(ringOut + i);
+		(dry * xn + sumLeft).store(left + i);
+
+		if(stereo)
+		{
+			(dry * xn + sumRight).store(right + i);
+		}
+	}
+
+	for(; i < numSamples; ++i)
+	{
+		const float xn = input[i];
+
+		float sumLeft = 0.0f;
+		float sumRight = 0.0f;
+		float sumFeedback = 0.0f;
+
+		for(int t = 0; t < numTaps; ++t)
+		{
+			const auto& tap = taps[t];
+			const float* reads = tapReads[t] + i;
+			const float yn = reads[1] + tap.delayFraction * (reads[0] - reads[1]);
+
+			sumFeedback += tap.feedback * yn;
+			sumLeft += (stereo ? tap.gainLeft : tap.settings.gain) * yn;
+			sumRight += tap.gainRight * yn;
+		}
+
+		ringOut[i] = xn + sumFeedback;
+		left[i] = dryLevel * xn + sumLeft;
+
+		if(stereo)
+		{
+			right[i] = dryLevel * xn + sumRight;
+		}
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "RingBuffer.h"
+
+#include <array>
+
+/*
+ * Several delay taps reading one shared history. Each tap has its own time,
+ * level, pan and feedback send; the feedback from every tap is summed into the
+ * single write, so a dotted eighth + quarter pattern costs one ring and one
+ * pass over the block instead of one DelayLine (and one 2 second buffer) per tap.
+ *
+ * Like DelayLine, the block is walked in runs that neither wrap nor outrun the
+ * shortest tap, and every run does all the taps for a vector of samples before
+ * moving on, so the tap reads stay close together in cache.
+ */
+class MultiTapDelay
+{
+public:
+	static constexpr int maxTaps = 8;
+
+	struct Tap
+	{
+		float delayMs	= 0.0f;
+		float gain		= 0.0f; // linear
+		float pan		= 0.0f; // -1 left .. 1 right, equal power
+		float feedback	= 0.0f; // linear send back into the line
+	};
+
+	// the sends all land in the one write, so it's their sizes added up that has to stay below 1
+	static constexpr float maxTotalFeedback = 0.98f;
+
+	MultiTapDelay();
+
+	// sizes the ring for maxDelayMs at sampleRate and clears it
+	void prepare(float sampleRate, float maxDelayMs = 2000.0f);
+	void reset();
+
+	void setNumTaps(int newNumTaps);
+	int getNumTaps() const
+	{
+		return numTaps;
+	}
+
+	// a set of sends adding up to more than maxTotalFeedback is scaled down as a whole, getTap() still has them as given
+	void setTap(int index, const Tap& tap);
+	const Tap& getTap(int index) const
+	{
+		return taps[index].settings;
+	}
+
+	// level of the input in the output, the taps are added on top
+	void setDryLevel(float level)
+	{
+		dryLevel = level;
+	}
+
+	// mono in place, pan is ignored
+	void process(float* audioBuffer, int numSamples);
+
+	// mono in, stereo out; input may be the same buffer as left or right
+	void process(const float* input, float* left, float* right, int numSamples);
+
+private:
+	struct CookedTap
+	{
+		Tap settings;
+
+		int delayWhole;
+		float delayFraction;
+		float gainLeft, gainRight;
+		float feedback;
+	};
+
+	void cookTap(CookedTap& tap);
+	void cookFeedback();
+	int getShortestDelay() const;
+
+	template <bool stereo>
+	void processBlock(const float* input, float* left, float* right, int numSamples);
+
+	template <bool stereo>
+	void processRun(const float* input, float* left, float* right, float* ringOut, const float* const* tapReads, int numSamples);
+
+private:
+	std::array<CookedTap, maxTaps> taps;
+	int numTaps;
+
+	float dryLevel;
+	float currentSampleRate;
+
+	RingBuffer buffer;
+	int writeIndex;
+};
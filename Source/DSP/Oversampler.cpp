@@ -0,0 +1,236 @@
+#include "Oversampler.h"
+#include "SIMD.h"
+
+#include <algorithm>
+#include <cmath>
+
+// modified Bessel function of the first kind, order 0, for the Kaiser window
+static double besselI0(double x)
+{
+	double sum = 1.0;
+	double term = 1.0;
+
+	for(int k = 1; k < 32; ++k)
+	{
+		const double t = x / (2.0 * k);
+		term *= t * t;
+		sum += term;
+	}
+
+	return sum;
+}
+
+HalfBandStage::HalfBandStage(int halfLength, float kaiserBeta)
+: halfLength		{halfLength}
+, phaseLength		{2 * halfLength}
+, coefficients		(static_cast<size_t>(2 * halfLength))
+, upHistory			(static_cast<size_t>(4 * halfLength))
+, upPosition		{0}
+, downEvenHistory	(static_cast<size_t>(4 * halfLength))
+, downOddHistory	(static_cast<size_t>(4 * halfLength))
+, downEvenPosition	{0}
+, downOddPosition	{0}
+{
+	// Kaiser windowed sinc with the cutoff at a quarter of the higher rate;
+	// only the even taps are kept, the odd ones are zero apart from the centre
+	const int numTaps = 4 * halfLength - 1;
+	const int centre = 2 * halfLength - 1;
+	const double beta = kaiserBeta;
+	const double pi = 3.14159265358979323846;
+
+	double sum = 0.0;
+	std::vector<double> taps(static_cast<size_t>(phaseLength));
+
+	for(int i = 0; i < phaseLength; ++i)
+	{
+		const int k = 2 * i;
+		const double x = 0.5 * pi * (k - centre);
+		const double r = 2.0 * k / (numTaps - 1) - 1.0;
+		const double window = besselI0(beta * std::sqrt(std::max(0.0, 1.0 - r * r))) / besselI0(beta);
+
+		taps[i] = 0.5 * std::sin(x) / x * window;
+		sum += taps[i];
+	}
+
+	// the FIR phase and the 0.5 centre tap each carry half of the DC gain
+	for(int i = 0; i < phaseLength; ++i)
+	{
+		coefficients[i] = static_cast<float>(taps[i] * 0.5 / sum);
+	}
+}
+
+void HalfBandStage::reset()
+{
+	std::fill(upHistory.begin(), upHistory.end(), 0.0f);
+	std::fill(downEvenHistory.begin(), downEvenHistory.end(), 0.0f);
+	std::fill(downOddHistory.begin(), downOddHistory.end(), 0.0f);
+	upPosition = 0;
+	downEvenPosition = 0;
+	downOddPosition = 0;
+}
+
+float HalfBandStage::pushAndFilter(std::vector<float>& history, int& position, float sample) const
+{
+	push(history, position, sample, 0);
+
+	// the window is the last phaseLength samples, oldest first; the filter is
+	// symmetric so it doesn't matter which way round the coefficients go
+	const float* window = history.data() + position + 1;
+	const float* h = coefficients.data();
+
+	Float4 acc = Float4::splat(0.0f);
+	for(int i = 0; i < phaseLength; i += Float4::size)
+	{
+		acc = acc + Float4::load(window + i) * Float4::load(h + i);
+	}
+
+	float lanes[Float4::size];
+	acc.store(lanes);
+
+	return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+float HalfBandStage::push(std::vector<float>& history, int& position, float sample, int delay)
+{
+	// written twice so history[position + 1 .. position + length] is always contiguous
+	const int length = static_cast<int>(history.size()) / 2;
+
+	position = position + 1 == length ? 0 : position + 1;
+	history[position] = sample;
+	history[position + length] = sample;
+
+	return history[position + length - delay];
+}
+
+void HalfBandStage::upsample(const float* input, float* output, int numSamples)
+{
+	for(int i = 0; i < numSamples; ++i)
+	{
+		const float filtered = pushAndFilter(upHistory, upPosition, input[i]);
+
+		// the other phase is just the centre tap, the input delayed to line up with the FIR
+		const float delayed = upHistory[upPosition + phaseLength - (halfLength - 1)];
+
+		// zero stuffing halves the level, the factor of two puts it back
+		output[2 * i] = 2.0f * filtered;
+		output[2 * i + 1] = delayed;
+	}
+}
+
+void HalfBandStage::downsample(const float* input, float* output, int numSamples)
+{
+	for(int i = 0; i < numSamples; ++i)
+	{
+		const float filtered = pushAndFilter(downEvenHistory, downEvenPosition, input[2 * i]);
+		const float centre = push(downOddHistory, downOddPosition, input[2 * i + 1], halfLength);
+
+		output[i] = filtered + 0.5f * centre;
+	}
+}
+
+float HalfBandStage::getLatency() const
+{
+	return static_cast<float>(2 * halfLength - 1);
+}
+
+//==============================================================================
+// { halfLength, Kaiser beta } per stage. The first stage has to keep the whole
+// audio band and reject everything above the host Nyquist, so it is the long
+// one (~70 dB). By the later stages the signal only fills the bottom quarter
+// of the band and the transition can be wide, so a quarter of the taps will do.
+static const struct { int halfLength; float beta; } stageDesigns[Oversampler::maxStages] = {
+	{ 12, 7.0f },
+	{ 4, 5.0f },
+	{ 4, 5.0f }
+};
+
+Oversampler::Oversampler()
+: numActiveStages	{0}
+{
+	stages.reserve(maxStages);
+	for(auto& design : stageDesigns)
+	{
+		stages.emplace_back(design.halfLength, design.beta);
+	}
+}
+
+void Oversampler::prepare(int maximumBlockSize)
+{
+	const size_t size = static_cast<size_t>(std::max(1, maximumBlockSize) * maxFactor);
+	bufferA.assign(size, 0.0f);
+	bufferB.assign(size, 0.0f);
+
+	reset();
+}
+
+void Oversampler::reset()
+{
+	for(auto& stage : stages)
+	{
+		stage.reset();
+	}
+}
+
+void Oversampler::setFactor(int newFactor)
+{
+	int newStages = 0;
+	while(newStages < maxStages && (2 << newStages) <= newFactor)
+	{
+		++newStages;
+	}
+
+	// stages coming back into use still hold whatever they had when they were dropped
+	for(int i = numActiveStages; i < newStages; ++i)
+	{
+		stages[i].reset();
+	}
+
+	numActiveStages = newStages;
+}
+
+float Oversampler::getLatencySamples() const
+{
+	// each stage delays by its group delay once going up and once coming down, at its own rate
+	float latency = 0.0f;
+	for(int i = 0; i < numActiveStages; ++i)
+	{
+		latency += 2.0f * stages[i].getLatency() / static_cast<float>(2 << i);
+	}
+
+	return latency;
+}
+
+float* Oversampler::upsample(const float* input, int numSamples)
+{
+	// ping-pong: the last stage always lands in bufferA or bufferB, never in the caller's buffer
+	const float* source = input;
+	float* destination = bufferA.data();
+
+	for(int i = 0; i < numActiveStages; ++i)
+	{
+		destination = i % 2 == 0 ? bufferA.data() : bufferB.data();
+		stages[i].upsample(source, destination, numSamples << i);
+		source = destination;
+	}
+
+	return destination;
+}
+
+void Oversampler::downsample(float* oversampled, float* output, int numSamples)
+{
+	float* source = oversampled;
+	float* destination = oversampled == bufferA.data() ? bufferB.data() : bufferA.data();
+
+	for(int i = numActiveStages - 1; i >= 0; --i)
+	{
+		// the last stage writes straight back into the host buffer
+		if(i == 0)
+		{
+			destination = output;
+		}
+
+		stages[i].downsample(source, destination, numSamples << i);
+
+		std::swap(source, destination);
+	}
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <vector>
+
+/*
+ * One 2x polyphase half-band FIR, used in both directions.
+ *
+ * A half-band filter has every other tap zero apart from the 0.5 centre tap,
+ * so split into its two phases one phase is a plain delay and the other is a
+ * short symmetric FIR. Each direction only ever runs that short FIR at the
+ * lower of the two rates, which is where the polyphase saving comes from.
+ * The FIR is a straight dot product over a contiguous window (the history is
+ * written twice so it never wraps) and runs on Float4.
+ */
+class HalfBandStage
+{
+public:
+	// halfLength = K, the filter has 4K - 1 taps of which 2K are in the FIR phase; K must be a multiple of 2.
+	// kaiserBeta trades transition width against stopband depth.
+	HalfBandStage(int halfLength, float kaiserBeta);
+
+	void reset();
+
+	// numSamples in, 2 * numSamples out
+	void upsample(const float* input, float* output, int numSamples);
+
+	// 2 * numSamples in, numSamples out
+	void downsample(const float* input, float* output, int numSamples);
+
+	// group delay of one direction, in samples at the higher rate
+	float getLatency() const;
+
+private:
+	float pushAndFilter(std::vector<float>& history, int& position, float sample) const;
+	static float push(std::vector<float>& history, int& position, float sample, int delay);
+
+	int halfLength;
+	int phaseLength;
+
+	// the non-zero FIR phase, h[0], h[2], ... h[4K - 2], symmetric
+	std::vector<float> coefficients;
+
+	std::vector<float> upHistory;
+	int upPosition;
+
+	std::vector<float> downEvenHistory;
+	std::vector<float> downOddHistory;
+	int downEvenPosition;
+	int downOddPosition;
+};
+
+/*
+ * Runs a block kernel at 2x, 4x or 8x the host rate by cascading half-band
+ * stages. The first stage has the steepest filter; later stages run at higher
+ * rates where the signal only fills the bottom of the band, so they get away
+ * with shorter filters. The factor can change at runtime (at a block boundary).
+ */
+class Oversampler
+{
+public:
+	static constexpr int maxStages = 3;
+	static constexpr int maxFactor = 1 << maxStages;
+
+	Oversampler();
+
+	// allocates for the largest factor, call before processing
+	void prepare(int maximumBlockSize);
+	void reset();
+
+	// 1, 2, 4 or 8; anything else is rounded down to the nearest of those
+	void setFactor(int newFactor);
+	int getFactor() const
+	{
+		return 1 << numActiveStages;
+	}
+
+	// up + down group delay in host rate samples
+	float getLatencySamples() const;
+
+	// kernel(float* buffer, int numSamples) runs in place at the oversampled rate
+	template <typename Kernel>
+	void process(float* buffer, int numSamples, Kernel&& kernel)
+	{
+		if(numActiveStages == 0)
+		{
+			kernel(buffer, numSamples);
+			return;
+		}
+
+		float* oversampled = upsample(buffer, numSamples);
+		kernel(oversampled, numSamples << numActiveStages);
+		downsample(oversampled, buffer, numSamples);
+	}
+
+private:
+	float* upsample(const float* input, int numSamples);
+	void downsample(float* oversampled, float* output, int numSamples);
+
+	std::vector<HalfBandStage> stages;
+	int numActiveStages;
+
+	// ping-pong buffers sized for maxFactor * maximumBlockSize
+	std::vector<float> bufferA, bufferB;
+};
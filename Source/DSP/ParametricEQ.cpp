@@ -0,0 +1,343 @@
+#include "ParametricEQ.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+constexpr int ParametricEQ::maxBands;
+constexpr int ParametricEQ::maxSections;
+constexpr int ParametricEQ::maxChannels;
+
+ParametricEQ::Design::Design()
+: numGroups	{1}
+, time		{0}
+{
+	for(auto& group : groups)
+	{
+		group = BiQuad<Float4>::passThrough();
+	}
+}
+
+ParametricEQ::ParametricEQ()
+: currentSampleRate	{0}
+, numBands			{0}
+, numSections		{0}
+, designWaiting		{false}
+, blockTime			{0}
+, numChannels		{1}
+{
+	reset();
+}
+
+void ParametricEQ::prepare(float sampleRate, int channels)
+{
+	std::lock_guard<std::mutex> lock(designLock);
+
+	currentSampleRate = sampleRate;
+	designBands(0);
+
+	// the audio thread isn't running, so the new design can go live straight away, no ramp
+	active = designs.acquire();
+	designWaiting = false;
+
+	numChannels = std::min(std::max(channels, 1), static_cast<int>(maxChannels));
+}
+
+void ParametricEQ::reset()
+{
+	pickUpDesign();
+
+	if(designWaiting)
+	{
+		active = waiting;
+		designWaiting = false;
+	}
+
+	for(auto& channel : state)
+	{
+		for(int group = 0; group < maxGroups; ++group)
+		{
+			channel.s1[group] = channel.s2[group] = Float4::splat(0.0f);
+		}
+	}
+}
+
+int ParametricEQ::countSections(const EQBand& band)
+{
+	const bool cascaded = (band.type == FilterType::LOW_PASS || band.type == FilterType::HIGH_PASS) && band.slope > 12;
+	return cascaded ? std::min(band.slope / 12, 4) : 1;
+}
+
+bool ParametricEQ::setBands(const EQBand* newBands, int numNewBands, int64_t time)
+{
+	std::lock_guard<std::mutex> lock(designLock);
+
+	numBands = std::min(std::max(numNewBands, 0), static_cast<int>(maxBands));
+	std::copy(newBands, newBands + numBands, bands);
+
+	return designBands(time) && numNewBands <= maxBands;
+}
+
+bool ParametricEQ::designBands(int64_t time)
+{
+	BiQuadDesign sections[maxSections];
+	bool allFit = true;
+	numSections = 0;
+
+	for(int i = 0; i < numBands; ++i)
+	{
+		const EQBand& band = bands[i];
+		const int bandSections = countSections(band);
+
+		// a band goes in whole or not at all
+		if(numSections + bandSections > maxSections)
+		{
+			allFit = false;
+			continue;
+		}
+
+		if(currentSampleRate <= 0)
+		{
+			numSections += bandSections;
+			continue;
+		}
+
+		if(bandSections == 1)
+		{
+			sections[numSections++] = BiQuadDesign::calculate(band.type, currentSampleRate, band.frequency, band.gain, band.Q);
+			continue;
+		}
+
+		// Butterworth of order 2 * bandSections, one conjugate pole pair per section
+		for(int k = 0; k < bandSections; ++k)
+		{
+			const double angle = PI * (2 * k + 1) / (4 * bandSections);
+			sections[numSections++] = BiQuadDesign::calculate(band.type, currentSampleRate, band.frequency, 0.0, 0.5 / std::cos(angle));
+		}
+	}
+
+	if(currentSampleRate <= 0)
+	{
+		return allFit;
+	}
+
+	Design& design = designs.getWriteBuffer();
+	design.numGroups = std::max(1, (numSections + Float4::size - 1) / Float4::size);
+	design.time = time;
+
+	for(int group = 0; group < maxGroups; ++group)
+	{
+		float laneB0[Float4::size], laneB1[Float4::size], laneB2[Float4::size];
+		float laneA1[Float4::size], laneA2[Float4::size];
+
+		for(int lane = 0; lane < Float4::size; ++lane)
+		{
+			const int section = group * Float4::size + lane;
+			const BiQuadDesign c = section < numSections ? sections[section] : BiQuadDesign { 1.0, 0.0, 0.0, 0.0, 0.0 };
+
+			laneB0[lane] = static_cast<float>(c.b0);
+			laneB1[lane] = static_cast<float>(c.b1);
+			laneB2[lane] = static_cast<float>(c.b2);
+			laneA1[lane] = static_cast<float>(c.a1);
+			laneA2[lane] = static_cast<float>(c.a2);
+		}
+
+		design.groups[group] = {
+			Float4::load(laneB0),
+			Float4::load(laneB1),
+			Float4::load(laneB2),
+			Float4::load(laneA1),
+			Float4::load(laneA2)
+		};
+	}
+
+	designs.publish();
+	return allFit;
+}
+
+// function(Count - 1) down to function(0) as straight-line code, so the per-group arrays it indexes can stay in registers
+template <typename Function, int... Index>
+static inline void forEachGroupDescending(Function&& function, std::integer_sequence<int, Index...>)
+{
+	// C++14 has no fold expressions, the braced list runs the calls in order
+	int called[] = { 0, (function(static_cast<int>(sizeof...(Index)) - 1 - Index), 0)... };
+	(void) called;
+}
+
+void ParametricEQ::pickUpDesign()
+{
+	bool changed;
+	const Design& published = designs.acquire(changed);
+
+	if(changed)
+	{
+		waiting = published;
+		designWaiting = true;
+	}
+}
+
+int ParametricEQ::takeDesigns(int64_t time, int numFrames)
+{
+	pickUpDesign();
+	blockTime = time;
+
+	if(designWaiting && waiting.time > time)
+	{
+		return static_cast<int>(std::min<int64_t>(numFrames, waiting.time - time));
+	}
+
+	return numFrames;
+}
+
+void ParametricEQ::process(float* frames, int numFrames)
+{
+	// block boundary, the one place a new design comes in; one that isn't due yet keeps waiting
+	pickUpDesign();
+
+	if(!designWaiting || waiting.time > blockTime)
+	{
+		for(int channel = 0; channel < numChannels; ++channel)
+		{
+			switch(active.numGroups)
+			{
+				case 1: processChannel<1, false>(active, active, channel, frames, numFrames); break;
+				case 2: processChannel<2, false>(active, active, channel, frames, numFrames); break;
+				case 3: processChannel<3, false>(active, active, channel, frames, numFrames); break;
+				case 4: processChannel<4, false>(active, active, channel, frames, numFrames); break;
+			}
+		}
+		return;
+	}
+
+	// ramp from what was running over this block; spare lanes pass through in both, so the wider layout covers the two
+	for(int channel = 0; channel < numChannels; ++channel)
+	{
+		switch(std::max(active.numGroups, waiting.numGroups))
+		{
+			case 1: processChannel<1, true>(active, waiting, channel, frames, numFrames); break;
+			case 2: processChannel<2, true>(active, waiting, channel, frames, numFrames); break;
+			case 3: processChannel<3, true>(active, waiting, channel, frames, numFrames); break;
+			case 4: processChannel<4, true>(active, waiting, channel, frames, numFrames); break;
+		}
+	}
+
+	active = waiting;
+	designWaiting = false;
+}
+
+template <int NumGroups, bool Ramp>
+void ParametricEQ::processChannel(const Design& from, const Design& to, int channel, float* frames, int numFrames)
+{
+	// steps from a sample entering lane 0 of the first group to it leaving the last lane of the last
+	const int depth = NumGroups * Float4::size - 1;
+	const int stride = numChannels;
+	float* samples = frames + channel;
+
+	using Section = BiQuad<Float4>;
+
+	// locals rather than members so the state stays in registers for the whole block
+	ChannelState& channelState = state[channel];
+	Float4 s1[NumGroups], s2[NumGroups];
+	Float4 out[NumGroups]; // each group's output from the previous step
+
+	// coefficients, and with Ramp how far they move per step to land on the new design as the last sample goes in
+	Section::Coefficients c[NumGroups], delta[NumGroups];
+
+	for(int group = 0; group < NumGroups; ++group)
+	{
+		s1[group] = channelState.s1[group];
+		s2[group] = channelState.s2[group];
+		out[group] = Float4::splat(0.0f);
+		c[group] = from.groups[group];
+
+		if(Ramp)
+		{
+			delta[group] = Section::rampStep(from.groups[group], to.groups[group], numFrames);
+		}
+	}
+
+	// linear steps between two stable designs are stable too, the region of stable (a1, a2) is a triangle
+	auto ramp = [&]
+	{
+		if(Ramp)
+		{
+			forEachGroupDescending([&](int group)
+			{
+				Section::advance(c[group], delta[group]);
+			}, std::make_integer_sequence<int, NumGroups>());
+		}
+	};
+
+	// last group first, so out[] still holds the previous step when the next group shifts it in
+	const auto groups = std::make_integer_sequence<int, NumGroups>();
+
+	auto step = [&](float input)
+	{
+		forEachGroupDescending([&](int group)
+		{
+			const Float4 xn = Float4::shiftIn(out[group], group == 0 ? Float4::splat(input) : out[group - 1]);
+			out[group] = Section::tick(c[group], xn, s1[group], s2[group]);
+		}, groups);
+	};
+
+	// while filling and draining, lane k only moves when its sample (step - k) is in this block
+	const float laneIndex[maxSections] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+
+	auto maskedStep = [&](float input, int position)
+	{
+		const Float4 newest = Float4::splat(static_cast<float>(position));
+		const Float4 oldest = Float4::splat(static_cast<float>(position - numFrames));
+
+		forEachGroupDescending([&](int group)
+		{
+			const Float4 lanes = Float4::load(laneIndex + group * Float4::size);
+			const auto active = Float4::both(Float4::lessOrEqual(lanes, newest), Float4::greaterThan(lanes, oldest));
+
+			const Float4 xn = Float4::shiftIn(out[group], group == 0 ? Float4::splat(input) : out[group - 1]);
+			Float4 z1 = s1[group], z2 = s2[group];
+			out[group] = Section::tick(c[group], xn, z1, z2);
+
+			s1[group] = Float4::select(active, z1, s1[group]);
+			s2[group] = Float4::select(active, z2, s2[group]);
+		}, groups);
+	};
+
+	int position = 0;
+
+	// fill: nothing has reached the end yet
+	for(const int filled = std::min(depth, numFrames); position < filled; ++position)
+	{
+		ramp();
+		maskedStep(samples[position * stride], position);
+	}
+
+	// full pipeline, the output lags the input by depth samples so writing in place is safe
+	for(; position < numFrames; ++position)
+	{
+		ramp();
+		step(samples[position * stride]);
+		samples[(position - depth) * stride] = out[NumGroups - 1].lastLane();
+	}
+
+	// drain, on exactly the new design rather than whatever the summed steps came to
+	for(int group = 0; Ramp && group < NumGroups; ++group)
+	{
+		c[group] = to.groups[group];
+	}
+
+	for(; position < numFrames + depth; ++position)
+	{
+		maskedStep(0.0f, position);
+
+		if(position >= depth)
+		{
+			samples[(position - depth) * stride] = out[NumGroups - 1].lastLane();
+		}
+	}
+
+	for(int group = 0; group < NumGroups; ++group)
+	{
+		channelState.s1[group] = s1[group];
+		channelState.s2[group] = s2[group];
+	}
+}
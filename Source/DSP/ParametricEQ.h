@@ -0,0 +1,147 @@
+#pragma once
+
+#include "BiQuad.h"
+#include "SIMD.h"
+#include "TripleBuffer.h"
+
+#include <cstdint>
+#include <mutex>
+
+/*
+ * One band of a ParametricEQ. PEAK, LOW_SHELF and HIGH_SHELF use gain and Q,
+ * LOW_PASS and HIGH_PASS use slope: 12 dB/octave is a single section with the
+ * given Q, 24/36/48 cascade two to four Butterworth sections (Q is ignored).
+ */
+struct EQBand
+{
+	FilterType type	= FilterType::PEAK;
+	float frequency	= 1000.0f;
+	float gain		= 0.0f; // dB
+	float Q			= 0.707f;
+	int slope		= 12; // dB/octave
+};
+
+/*
+ * A cascade of up to maxBands EQ bands run in a single pass over the block.
+ *
+ * Every band is one or more biquad sections, and the sections are laid out
+ * structure-of-arrays: section k's coefficients and TDF2 state sit in lane
+ * k % 4 of the k / 4'th Float4. Rather than taking each sample through the
+ * sections one after another (a chain of dependent multiply-adds per section),
+ * the cascade is pipelined across the lanes: at each step lane k works on the
+ * sample k steps behind lane 0, with its input shifted over from lane k - 1.
+ * Every lane's recursion is then in flight at once, so a step costs about
+ * one biquad whatever the number of sections, and a sample comes out of the
+ * last section as many steps after it went in as there are sections.
+ *
+ * The pipeline is filled and drained inside each block (the lanes that have
+ * no sample of this block are masked off), so there's no added latency and
+ * between blocks every section has seen exactly the same samples. Spare lanes
+ * run a pass-through section. Each step is BiQuad<Float4>::tick(), and the
+ * coefficients are BiQuadDesign's, so results match a cascade of BiQuads.
+ *
+ * Designing the sections is the expensive part of a change, so it is done
+ * on the control thread and the finished coefficient set handed over through
+ * a TripleBuffer; the audio thread only ever swaps in a complete design
+ * between blocks. A design can be stamped with the sample it's for, on the
+ * caller's timeline (see takeDesigns()), and waits until then. The block a
+ * new design goes live in ramps every coefficient linearly from the old
+ * design to the new one, so knob moves and sweeps don't step, and the ramp
+ * costs five adds per group and step.
+ *
+ * Channels are interleaved in frames (1, 2 or 4 wide, see Effect); each one
+ * runs its own pipeline over the block.
+ */
+class ParametricEQ
+{
+public:
+	static constexpr int maxBands = 10;
+	static constexpr int maxSections = 16;
+	static constexpr int maxChannels = 4;
+
+	ParametricEQ();
+
+	// never while process() is running, designs the current bands for the new rate
+	void prepare(float sampleRate, int numChannels);
+
+	// likewise; a design still waiting goes live, the timeline it was stamped for has stopped
+	void reset();
+
+	/*
+	 * Control thread, never the audio one. The sections are designed right
+	 * here (sin, cos and pow per band) and published; process() picks the
+	 * newest design up at the start of its next block, or the first block
+	 * from time on, and the state is left alone. Only the newest design waits:
+	 * one published while an earlier one is still waiting replaces it. Before
+	 * prepare() the bands are just kept for it to design. Bands past maxBands,
+	 * or that don't fit in what's left of maxSections, are dropped and it
+	 * returns false.
+	 */
+	bool setBands(const EQBand* bands, int numBands, int64_t time = 0);
+
+	/*
+	 * Audio thread, before process(), for callers that stamp designs: the
+	 * block about to be processed starts at time, and the result is numFrames
+	 * cut short to end where a waiting design is due, so it goes live on its
+	 * sample. Callers that don't call it leave every design's time at 0.
+	 */
+	int takeDesigns(int64_t time, int numFrames);
+
+	// sections the last setBands() came to, control thread
+	int getNumSections() const
+	{
+		return numSections;
+	}
+
+	// numFrames frames of the prepared number of channels, in place
+	void process(float* frames, int numFrames);
+
+private:
+	static constexpr int maxGroups = maxSections / Float4::size;
+
+	// section k in lane k % 4 of group k / 4, spare lanes pass straight through
+	struct Design
+	{
+		Design();
+
+		BiQuad<Float4>::Coefficients groups[maxGroups];
+
+		int numGroups; // Float4s the sections take up
+		int64_t time; // when it goes live, see setBands()
+	};
+
+	struct ChannelState
+	{
+		Float4 s1[maxGroups], s2[maxGroups];
+	};
+
+	static int countSections(const EQBand& band);
+
+	// designs bands into the write buffer and publishes it, designLock held
+	bool designBands(int64_t time);
+
+	// audio side, moves a newly published design to waiting
+	void pickUpDesign();
+
+	template <int NumGroups, bool Ramp>
+	void processChannel(const Design& from, const Design& to, int channel, float* frames, int numFrames);
+
+	// control side, designLock keeps setBands() and prepare() apart; the audio thread never takes it
+	std::mutex designLock;
+	float currentSampleRate;
+	EQBand bands[maxBands];
+	int numBands;
+	int numSections;
+
+	TripleBuffer<Design> designs;
+
+	// audio side, the design the filters are running (a copy, the writer reuses the buffer it came from)
+	Design active;
+
+	// the newest published design until it's due, and the block start takeDesigns() was last given
+	Design waiting;
+	bool designWaiting;
+	int64_t blockTime;
+	int numChannels;
+	ChannelState state[maxChannels];
+};
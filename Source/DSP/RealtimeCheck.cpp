@@ -0,0 +1,398 @@
+#include "RealtimeCheck.h"
+
+constexpr bool RealtimeCheck::compiledIn;
+std::atomic<uint32_t> RealtimeCheck::violations {0};
+
+#if !FX_REALTIME_CHECK
+
+void RealtimeCheck::enter() {}
+void RealtimeCheck::leave() {}
+void RealtimeCheck::violation(const char*) {}
+
+#else
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/select.h>
+#include <time.h>
+#include <unistd.h>
+
+// how deep in RealtimeScopes this thread is, and whether the checks are off while it reports or looks a function up
+static thread_local int depth = 0;
+static thread_local bool suspended = false;
+
+static bool isRealtime()
+{
+	return depth > 0 && !suspended;
+}
+
+static void check(const char* what)
+{
+	if(isRealtime())
+	{
+		RealtimeCheck::violation(what);
+	}
+}
+
+// the next definition of name after this program's, found the first time it's called
+template <typename Function>
+static Function lookUp(const char* name)
+{
+	const bool wasSuspended = suspended;
+	suspended = true;
+
+	auto function = reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+
+	suspended = wasSuspended;
+	return function;
+}
+
+#define REAL(name) ([] { static const auto function = lookUp<decltype(&::name)>(#name); return function; }())
+
+//==============================================================================
+// backtraces reported so far, by a hash of their frames; past the end they're only counted
+static constexpr int maxSites = 256;
+static std::atomic<uint64_t> sites[maxSites];
+
+static bool isNewSite(void* const* frames, int numFrames)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for(int i = 0; i < numFrames; ++i)
+	{
+		hash = (hash ^ reinterpret_cast<uintptr_t>(frames[i])) * 1099511628211ull;
+	}
+
+	// 0 marks a free slot
+	hash |= 1;
+
+	for(auto& site : sites)
+	{
+		uint64_t expected = 0;
+		if(site.compare_exchange_strong(expected, hash) || expected == hash)
+		{
+			return expected == 0;
+		}
+	}
+
+	return false;
+}
+
+void RealtimeCheck::enter()
+{
+	++depth;
+}
+
+void RealtimeCheck::leave()
+{
+	--depth;
+}
+
+void RealtimeCheck::violation(const char* what)
+{
+	violations.fetch_add(1, std::memory_order_relaxed);
+
+	// everything from here on does what's being reported
+	suspended = true;
+
+	void* frames[32];
+	const int numFrames = backtrace(frames, 32);
+
+	// frame 0 is this function
+	if(isNewSite(frames + 1, numFrames - 1))
+	{
+		dprintf(STDERR_FILENO, "real-time violation: %s inside a RealtimeScope\n", what);
+		backtrace_symbols_fd(frames + 1, numFrames - 1, STDERR_FILENO);
+	}
+
+	suspended = false;
+}
+
+// the first backtrace() loads libgcc, better at startup than in the first report
+__attribute__((constructor)) static void loadBacktrace()
+{
+	void* frame;
+	backtrace(&frame, 1);
+}
+
+//==============================================================================
+// the heap, through glibc's own entry points rather than dlsym, which allocates itself
+extern "C" void* __libc_malloc(size_t);
+extern "C" void* __libc_calloc(size_t, size_t);
+extern "C" void* __libc_realloc(void*, size_t);
+extern "C" void __libc_free(void*);
+extern "C" void* __libc_memalign(size_t, size_t);
+
+extern "C" void* malloc(size_t size) noexcept
+{
+	check("malloc");
+	return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) noexcept
+{
+	check("calloc");
+	return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size) noexcept
+{
+	check("realloc");
+	return __libc_realloc(pointer, size);
+}
+
+extern "C" void free(void* pointer) noexcept
+{
+	if(pointer != nullptr)
+	{
+		check("free");
+	}
+
+	__libc_free(pointer);
+}
+
+extern "C" void* memalign(size_t alignment, size_t size) noexcept
+{
+	check("memalign");
+	return __libc_memalign(alignment, size);
+}
+
+extern "C" void* aligned_alloc(size_t alignment, size_t size) noexcept
+{
+	check("aligned_alloc");
+	return __libc_memalign(alignment, size);
+}
+
+extern "C" int posix_memalign(void** result, size_t alignment, size_t size) noexcept
+{
+	check("posix_memalign");
+
+	if(alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0)
+	{
+		return EINVAL;
+	}
+
+	*result = __libc_memalign(alignment, size);
+	return *result != nullptr ? 0 : ENOMEM;
+}
+
+//==============================================================================
+// locks; condition waits need their mutex locked first, so they're caught without interposing their versioned symbols
+extern "C" int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept
+{
+	check("pthread_mutex_lock");
+	return REAL(pthread_mutex_lock)(mutex);
+}
+
+extern "C" int pthread_rwlock_rdlock(pthread_rwlock_t* lock) noexcept
+{
+	check("pthread_rwlock_rdlock");
+	return REAL(pthread_rwlock_rdlock)(lock);
+}
+
+extern "C" int pthread_rwlock_wrlock(pthread_rwlock_t* lock) noexcept
+{
+	check("pthread_rwlock_wrlock");
+	return REAL(pthread_rwlock_wrlock)(lock);
+}
+
+extern "C" int sem_wait(sem_t* semaphore)
+{
+	check("sem_wait");
+	return REAL(sem_wait)(semaphore);
+}
+
+extern "C" int sem_timedwait(sem_t* semaphore, const struct timespec* timeout)
+{
+	check("sem_timedwait");
+	return REAL(sem_timedwait)(semaphore, timeout);
+}
+
+extern "C" int pthread_join(pthread_t thread, void** result)
+{
+	check("pthread_join");
+	return REAL(pthread_join)(thread, result);
+}
+
+//==============================================================================
+// stdio
+extern "C" FILE* fopen(const char* path, const char* mode)
+{
+	check("fopen");
+	return REAL(fopen)(path, mode);
+}
+
+extern "C" int fclose(FILE* stream)
+{
+	check("fclose");
+	return REAL(fclose)(stream);
+}
+
+extern "C" size_t fread(void* data, size_t size, size_t count, FILE* stream)
+{
+	check("fread");
+	return REAL(fread)(data, size, count, stream);
+}
+
+extern "C" size_t fwrite(const void* data, size_t size, size_t count, FILE* stream)
+{
+	check("fwrite");
+	return REAL(fwrite)(data, size, count, stream);
+}
+
+extern "C" int fflush(FILE* stream)
+{
+	check("fflush");
+	return REAL(fflush)(stream);
+}
+
+extern "C" int fputs(const char* text, FILE* stream)
+{
+	check("fputs");
+	return REAL(fputs)(text, stream);
+}
+
+extern "C" int puts(const char* text)
+{
+	check("puts");
+	return REAL(puts)(text);
+}
+
+extern "C" int fputc(int c, FILE* stream)
+{
+	check("fputc");
+	return REAL(fputc)(c, stream);
+}
+
+extern "C" int putc(int c, FILE* stream)
+{
+	check("putc");
+	return REAL(putc)(c, stream);
+}
+
+extern "C" int putchar(int c)
+{
+	check("putchar");
+	return REAL(putchar)(c);
+}
+
+extern "C" int vfprintf(FILE* stream, const char* format, va_list args)
+{
+	check("vfprintf");
+	return REAL(vfprintf)(stream, format, args);
+}
+
+extern "C" int vprintf(const char* format, va_list args)
+{
+	check("vprintf");
+	return REAL(vfprintf)(stdout, format, args);
+}
+
+extern "C" int fprintf(FILE* stream, const char* format, ...)
+{
+	check("fprintf");
+
+	va_list args;
+	va_start(args, format);
+	const int result = REAL(vfprintf)(stream, format, args);
+	va_end(args);
+
+	return result;
+}
+
+extern "C" int printf(const char* format, ...)
+{
+	check("printf");
+
+	va_list args;
+	va_start(args, format);
+	const int result = REAL(vfprintf)(stdout, format, args);
+	va_end(args);
+
+	return result;
+}
+
+//==============================================================================
+// file descriptors
+extern "C" int open(const char* path, int flags, ...)
+{
+	check("open");
+
+	va_list args;
+	va_start(args, flags);
+	const mode_t mode = (flags & (O_CREAT | O_TMPFILE)) != 0 ? va_arg(args, mode_t) : 0;
+	va_end(args);
+
+	return REAL(open)(path, flags, mode);
+}
+
+extern "C" int close(int fd)
+{
+	check("close");
+	return REAL(close)(fd);
+}
+
+extern "C" ssize_t read(int fd, void* data, size_t size)
+{
+	check("read");
+	return REAL(read)(fd, data, size);
+}
+
+extern "C" ssize_t write(int fd, const void* data, size_t size)
+{
+	check("write");
+	return REAL(write)(fd, data, size);
+}
+
+extern "C" int fsync(int fd)
+{
+	check("fsync");
+	return REAL(fsync)(fd);
+}
+
+//==============================================================================
+// sleeping and waiting
+extern "C" int nanosleep(const struct timespec* duration, struct timespec* remaining)
+{
+	check("nanosleep");
+	return REAL(nanosleep)(duration, remaining);
+}
+
+extern "C" int clock_nanosleep(clockid_t clock, int flags, const struct timespec* duration, struct timespec* remaining)
+{
+	check("clock_nanosleep");
+	return REAL(clock_nanosleep)(clock, flags, duration, remaining);
+}
+
+extern "C" int usleep(useconds_t microseconds)
+{
+	check("usleep");
+	return REAL(usleep)(microseconds);
+}
+
+extern "C" unsigned int sleep(unsigned int seconds)
+{
+	check("sleep");
+	return REAL(sleep)(seconds);
+}
+
+extern "C" int poll(struct pollfd* fds, nfds_t numFds, int timeout)
+{
+	check("poll");
+	return REAL(poll)(fds, numFds, timeout);
+}
+
+extern "C" int select(int numFds, fd_set* readFds, fd_set* writeFds, fd_set* exceptFds, struct timeval* timeout)
+{
+	check("select");
+	return REAL(select)(numFds, readFds, writeFds, exceptFds, timeout);
+}
+
+#endif
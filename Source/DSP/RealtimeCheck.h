@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/*
+ * Catches the audio callback doing what it mustn't. Built with
+ * FX_REALTIME_CHECK=1 (the Debug configurations), the program interposes
+ * malloc and friends, mutex locks and condition waits, stdio and file I/O,
+ * and sleeping or polling syscalls. Any of them called on a thread inside a
+ * RealtimeScope counts as a violation, and the first one from each call site
+ * is reported on stderr with a backtrace (addr2line -f -e the binary turns
+ * its offsets into lines). Reporting isn't real-time safe either, but by
+ * then there's a bug to fix anyway.
+ *
+ * Only glibc on Linux, which is what the pedal runs on. Without the define
+ * RealtimeScope is empty and there are never any violations.
+ */
+#ifndef FX_REALTIME_CHECK
+ #define FX_REALTIME_CHECK 0
+#endif
+
+class RealtimeCheck
+{
+public:
+	static constexpr bool compiledIn = FX_REALTIME_CHECK != 0;
+
+	// since the program started, from every thread
+	static uint32_t getViolations()
+	{
+		return violations.load(std::memory_order_relaxed);
+	}
+
+	static void enter();
+	static void leave();
+
+	// called by the interposed functions, with what was called
+	static void violation(const char* what);
+
+private:
+	static std::atomic<uint32_t> violations;
+};
+
+// marks the calling thread as real-time until it goes; they nest
+class RealtimeScope
+{
+public:
+	RealtimeScope()
+	{
+	#if FX_REALTIME_CHECK
+		RealtimeCheck::enter();
+	#endif
+	}
+
+	~RealtimeScope()
+	{
+	#if FX_REALTIME_CHECK
+		RealtimeCheck::leave();
+	#endif
+	}
+
+	RealtimeScope(const RealtimeScope&) = delete;
+	RealtimeScope& operator=(const RealtimeScope&) = delete;
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+/*
+ * Raw float ring with a power-of-two length, so wrapping is a mask instead of
+ * a compare and branch. A few guard samples past the end mirror the start,
+ * which lets an interpolator read position .. position + guard from one plain
+ * pointer even across the wrap (one guard sample for two points, three for four).
+ *
+ * Nothing in here loops per sample; callers split their block into the
+ * contiguous runs getContiguous() hands out (two at most for one cursor)
+ * and do the work on straight pointers.
+ */
+class RingBuffer
+{
+public:
+	RingBuffer()
+	: size			{0}
+	, mask			{0}
+	, guardSize		{1}
+	{
+	}
+
+	// rounds up to the next power of two, clears the contents
+	void setSize(int minimumSize, int guardSamples = 1)
+	{
+		size = 1;
+		while(size < std::max(minimumSize, guardSamples))
+		{
+			size <<= 1;
+		}
+
+		mask = size - 1;
+		guardSize = guardSamples;
+		storage.assign(static_cast<size_t>(size + guardSize), 0.0f);
+	}
+
+	void clear()
+	{
+		std::fill(storage.begin(), storage.end(), 0.0f);
+	}
+
+	int getSize() const
+	{
+		return size;
+	}
+
+	int wrap(int position) const
+	{
+		return position & mask;
+	}
+
+	// samples from position (wrapped) to the end of the ring, capped at length
+	int getContiguous(int position, int length) const
+	{
+		return std::min(length, size - wrap(position));
+	}
+
+	float* getPointer(int position)
+	{
+		return storage.data() + wrap(position);
+	}
+
+	const float* getPointer(int position) const
+	{
+		return storage.data() + wrap(position);
+	}
+
+	float read(int position) const
+	{
+		return storage[static_cast<size_t>(wrap(position))];
+	}
+
+	// call after writing a run that started at position, refreshes the guard if the run touched it
+	void updateGuard(int position)
+	{
+		if(wrap(position) < guardSize)
+		{
+			std::copy(storage.begin(), storage.begin() + guardSize, storage.begin() + size);
+		}
+	}
+
+private:
+	int size;
+	int mask;
+	int guardSize;
+
+	// size + guardSize samples, the guard mirrors the first guardSize
+	std::vector<float> storage;
+};
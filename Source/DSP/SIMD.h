@@ -0,0 +1,338 @@
+#pragma once
+
+/*
+ * Minimal SIMD float vectors for the block kernels.
+ *
+ * Float4 is always four lanes: SSE on x86, NEON on ARM, plain floats elsewhere.
+ * Float8 (AVX) is only there when the compiler targets AVX.
+ * FloatVector is the widest one available and is what the kernels loop with.
+ *
+ * loadFirst/storeFirst move just the first 1, 2 or 4 lanes, for frames of
+ * interleaved channels narrower than a vector (the rest load as zero).
+ * Masks come out of the comparisons and go into select(); they are all-ones
+ * or all-zeros per lane so they can be combined with both(). laneBits() packs
+ * a Float4 mask into an int, bit k for lane k.
+ * shiftIn() moves every lane of a Float4 up by one and feeds lane 0 from the
+ * last lane of another vector, for running a chain of filters one per lane.
+ * Define FX_SIMD_SCALAR to force the plain C++ path (handy for checking results).
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if !defined(FX_SIMD_SCALAR)
+ #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define FX_SIMD_SSE 1
+  #include <immintrin.h>
+  #if defined(__AVX__)
+   #define FX_SIMD_AVX 1
+  #endif
+ #elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  #define FX_SIMD_NEON 1
+  #include <arm_neon.h>
+ #endif
+#endif
+
+//==============================================================================
+struct Float4
+{
+	static constexpr int size = 4;
+
+#if FX_SIMD_SSE
+	using Native = __m128;
+	using Mask = __m128;
+#elif FX_SIMD_NEON
+	using Native = float32x4_t;
+	using Mask = uint32x4_t;
+#else
+	struct Native { float lane[4]; };
+	struct Mask { uint32_t lane[4]; };
+#endif
+
+	Native v;
+
+	Float4() = default;
+	Float4(Native native) : v(native) {}
+
+#if FX_SIMD_SSE
+	static Float4 load(const float* p)		{ return _mm_loadu_ps(p); }
+	void store(float* p) const				{ _mm_storeu_ps(p, v); }
+	static Float4 splat(float x)			{ return _mm_set1_ps(x); }
+
+	static Float4 loadFirst(const float* p, int count)
+	{
+		return count == 1 ? _mm_load_ss(p)
+			: count == 2 ? _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(p)))
+			: _mm_loadu_ps(p);
+	}
+
+	void storeFirst(float* p, int count) const
+	{
+		if(count == 1)		_mm_store_ss(p, v);
+		else if(count == 2)	_mm_store_sd(reinterpret_cast<double*>(p), _mm_castps_pd(v));
+		else				_mm_storeu_ps(p, v);
+	}
+
+	friend Float4 operator+(Float4 a, Float4 b)	{ return _mm_add_ps(a.v, b.v); }
+	friend Float4 operator-(Float4 a, Float4 b)	{ return _mm_sub_ps(a.v, b.v); }
+	friend Float4 operator*(Float4 a, Float4 b)	{ return _mm_mul_ps(a.v, b.v); }
+	friend Float4 operator/(Float4 a, Float4 b)	{ return _mm_div_ps(a.v, b.v); }
+
+	static Float4 min(Float4 a, Float4 b)	{ return _mm_min_ps(a.v, b.v); }
+	static Float4 max(Float4 a, Float4 b)	{ return _mm_max_ps(a.v, b.v); }
+	static Float4 abs(Float4 a)				{ return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); }
+
+	// copies the sign of b onto the magnitude of a
+	static Float4 copySign(Float4 a, Float4 b)
+	{
+		const __m128 signBit = _mm_set1_ps(-0.0f);
+		return _mm_or_ps(_mm_andnot_ps(signBit, a.v), _mm_and_ps(signBit, b.v));
+	}
+
+	static Mask lessThan(Float4 a, Float4 b)		{ return _mm_cmplt_ps(a.v, b.v); }
+	static Mask lessOrEqual(Float4 a, Float4 b)		{ return _mm_cmple_ps(a.v, b.v); }
+	static Mask greaterOrEqual(Float4 a, Float4 b)	{ return _mm_cmpge_ps(a.v, b.v); }
+	static Mask greaterThan(Float4 a, Float4 b)		{ return _mm_cmpgt_ps(a.v, b.v); }
+	static Mask both(Mask a, Mask b)				{ return _mm_and_ps(a, b); }
+	static int laneBits(Mask mask)					{ return _mm_movemask_ps(mask); }
+
+	// lane-wise mask ? a : b
+	static Float4 select(Mask mask, Float4 a, Float4 b)
+	{
+		return _mm_or_ps(_mm_and_ps(mask, a.v), _mm_andnot_ps(mask, b.v));
+	}
+
+	// { carry[3], a[0], a[1], a[2] }
+	static Float4 shiftIn(Float4 a, Float4 carry)
+	{
+		const __m128 edge = _mm_shuffle_ps(carry.v, a.v, _MM_SHUFFLE(0, 0, 3, 3));
+		return _mm_shuffle_ps(edge, a.v, _MM_SHUFFLE(2, 1, 2, 0));
+	}
+
+	float lastLane() const					{ return _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))); }
+#elif FX_SIMD_NEON
+	static Float4 load(const float* p)		{ return vld1q_f32(p); }
+	void store(float* p) const				{ vst1q_f32(p, v); }
+	static Float4 splat(float x)			{ return vdupq_n_f32(x); }
+
+	static Float4 loadFirst(const float* p, int count)
+	{
+		return count == 1 ? vsetq_lane_f32(*p, vdupq_n_f32(0.0f), 0)
+			: count == 2 ? vcombine_f32(vld1_f32(p), vdup_n_f32(0.0f))
+			: vld1q_f32(p);
+	}
+
+	void storeFirst(float* p, int count) const
+	{
+		if(count == 1)		vst1q_lane_f32(p, v, 0);
+		else if(count == 2)	vst1_f32(p, vget_low_f32(v));
+		else				vst1q_f32(p, v);
+	}
+
+	friend Float4 operator+(Float4 a, Float4 b)	{ return vaddq_f32(a.v, b.v); }
+	friend Float4 operator-(Float4 a, Float4 b)	{ return vsubq_f32(a.v, b.v); }
+	friend Float4 operator*(Float4 a, Float4 b)	{ return vmulq_f32(a.v, b.v); }
+	friend Float4 operator/(Float4 a, Float4 b)
+	{
+	#if defined(__aarch64__)
+		return vdivq_f32(a.v, b.v);
+	#else
+		// armv7 has no vector divide, refine the reciprocal estimate twice (~full float precision)
+		float32x4_t r = vrecpeq_f32(b.v);
+		r = vmulq_f32(vrecpsq_f32(b.v, r), r);
+		r = vmulq_f32(vrecpsq_f32(b.v, r), r);
+		return vmulq_f32(a.v, r);
+	#endif
+	}
+
+	static Float4 min(Float4 a, Float4 b)	{ return vminq_f32(a.v, b.v); }
+	static Float4 max(Float4 a, Float4 b)	{ return vmaxq_f32(a.v, b.v); }
+	static Float4 abs(Float4 a)				{ return vabsq_f32(a.v); }
+
+	static Float4 copySign(Float4 a, Float4 b)
+	{
+		const uint32x4_t signBit = vdupq_n_u32(0x80000000u);
+		return vbslq_f32(signBit, b.v, a.v);
+	}
+
+	static Mask lessThan(Float4 a, Float4 b)		{ return vcltq_f32(a.v, b.v); }
+	static Mask lessOrEqual(Float4 a, Float4 b)		{ return vcleq_f32(a.v, b.v); }
+	static Mask greaterOrEqual(Float4 a, Float4 b)	{ return vcgeq_f32(a.v, b.v); }
+	static Mask greaterThan(Float4 a, Float4 b)		{ return vcgtq_f32(a.v, b.v); }
+	static Mask both(Mask a, Mask b)				{ return vandq_u32(a, b); }
+
+	static int laneBits(Mask mask)
+	{
+		const uint32_t weights[4] = { 1, 2, 4, 8 };
+		const uint32x4_t bits = vandq_u32(mask, vld1q_u32(weights));
+	#if defined(__aarch64__)
+		return static_cast<int>(vaddvq_u32(bits));
+	#else
+		const uint32x2_t pairs = vadd_u32(vget_low_u32(bits), vget_high_u32(bits));
+		return static_cast<int>(vget_lane_u32(vpadd_u32(pairs, pairs), 0));
+	#endif
+	}
+
+	static Float4 select(Mask mask, Float4 a, Float4 b)
+	{
+		return vbslq_f32(mask, a.v, b.v);
+	}
+
+	static Float4 shiftIn(Float4 a, Float4 carry)	{ return vextq_f32(carry.v, a.v, 3); }
+	float lastLane() const						{ return vgetq_lane_f32(v, 3); }
+#else
+	template <typename Op>
+	static Float4 map(Float4 a, Float4 b, Op op)
+	{
+		Float4 r;
+		for(int i = 0; i < 4; ++i)
+		{
+			r.v.lane[i] = op(a.v.lane[i], b.v.lane[i]);
+		}
+		return r;
+	}
+
+	template <typename Op>
+	static Mask compare(Float4 a, Float4 b, Op op)
+	{
+		Mask m;
+		for(int i = 0; i < 4; ++i)
+		{
+			m.lane[i] = op(a.v.lane[i], b.v.lane[i]) ? 0xffffffffu : 0u;
+		}
+		return m;
+	}
+
+	static Float4 load(const float* p)		{ Float4 r; std::memcpy(r.v.lane, p, sizeof(r.v.lane)); return r; }
+	void store(float* p) const				{ std::memcpy(p, v.lane, sizeof(v.lane)); }
+	static Float4 splat(float x)			{ Float4 r; for(auto& l : r.v.lane) l = x; return r; }
+
+	static Float4 loadFirst(const float* p, int count)
+	{
+		Float4 r = splat(0.0f);
+		std::memcpy(r.v.lane, p, sizeof(float) * static_cast<size_t>(count));
+		return r;
+	}
+
+	void storeFirst(float* p, int count) const
+	{
+		std::memcpy(p, v.lane, sizeof(float) * static_cast<size_t>(count));
+	}
+
+	friend Float4 operator+(Float4 a, Float4 b)	{ return map(a, b, [](float x, float y) { return x + y; }); }
+	friend Float4 operator-(Float4 a, Float4 b)	{ return map(a, b, [](float x, float y) { return x - y; }); }
+	friend Float4 operator*(Float4 a, Float4 b)	{ return map(a, b, [](float x, float y) { return x * y; }); }
+	friend Float4 operator/(Float4 a, Float4 b)	{ return map(a, b, [](float x, float y) { return x / y; }); }
+
+	static Float4 min(Float4 a, Float4 b)	{ return map(a, b, [](float x, float y) { return y < x ? y : x; }); }
+	static Float4 max(Float4 a, Float4 b)	{ return map(a, b, [](float x, float y) { return x < y ? y : x; }); }
+	static Float4 abs(Float4 a)				{ return map(a, a, [](float x, float) { return x < 0 ? -x : x; }); }
+
+	static Float4 copySign(Float4 a, Float4 b)
+	{
+		return map(a, b, [](float x, float y)
+		{
+			float m = x < 0 ? -x : x;
+			return std::signbit(y) ? -m : m;
+		});
+	}
+
+	static Mask lessThan(Float4 a, Float4 b)		{ return compare(a, b, [](float x, float y) { return x < y; }); }
+	static Mask lessOrEqual(Float4 a, Float4 b)		{ return compare(a, b, [](float x, float y) { return x <= y; }); }
+	static Mask greaterOrEqual(Float4 a, Float4 b)	{ return compare(a, b, [](float x, float y) { return x >= y; }); }
+	static Mask greaterThan(Float4 a, Float4 b)		{ return compare(a, b, [](float x, float y) { return x > y; }); }
+	static Mask both(Mask a, Mask b)
+	{
+		Mask m;
+		for(int i = 0; i < 4; ++i)
+		{
+			m.lane[i] = a.lane[i] & b.lane[i];
+		}
+		return m;
+	}
+
+	static int laneBits(Mask mask)
+	{
+		int bits = 0;
+		for(int i = 0; i < 4; ++i)
+		{
+			bits |= mask.lane[i] ? 1 << i : 0;
+		}
+		return bits;
+	}
+
+	static Float4 select(Mask mask, Float4 a, Float4 b)
+	{
+		Float4 r;
+		for(int i = 0; i < 4; ++i)
+		{
+			r.v.lane[i] = mask.lane[i] ? a.v.lane[i] : b.v.lane[i];
+		}
+		return r;
+	}
+
+	static Float4 shiftIn(Float4 a, Float4 carry)
+	{
+		Float4 r;
+		r.v.lane[0] = carry.v.lane[3];
+		for(int i = 1; i < 4; ++i)
+		{
+			r.v.lane[i] = a.v.lane[i - 1];
+		}
+		return r;
+	}
+
+	float lastLane() const					{ return v.lane[3]; }
+#endif
+};
+
+//==============================================================================
+#if FX_SIMD_AVX
+struct Float8
+{
+	static constexpr int size = 8;
+
+	using Native = __m256;
+	using Mask = __m256;
+
+	Native v;
+
+	Float8() = default;
+	Float8(Native native) : v(native) {}
+
+	static Float8 load(const float* p)		{ return _mm256_loadu_ps(p); }
+	void store(float* p) const				{ _mm256_storeu_ps(p, v); }
+	static Float8 splat(float x)			{ return _mm256_set1_ps(x); }
+
+	friend Float8 operator+(Float8 a, Float8 b)	{ return _mm256_add_ps(a.v, b.v); }
+	friend Float8 operator-(Float8 a, Float8 b)	{ return _mm256_sub_ps(a.v, b.v); }
+	friend Float8 operator*(Float8 a, Float8 b)	{ return _mm256_mul_ps(a.v, b.v); }
+	friend Float8 operator/(Float8 a, Float8 b)	{ return _mm256_div_ps(a.v, b.v); }
+
+	static Float8 min(Float8 a, Float8 b)	{ return _mm256_min_ps(a.v, b.v); }
+	static Float8 max(Float8 a, Float8 b)	{ return _mm256_max_ps(a.v, b.v); }
+	static Float8 abs(Float8 a)				{ return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v); }
+
+	static Float8 copySign(Float8 a, Float8 b)
+	{
+		const __m256 signBit = _mm256_set1_ps(-0.0f);
+		return _mm256_or_ps(_mm256_andnot_ps(signBit, a.v), _mm256_and_ps(signBit, b.v));
+	}
+
+	static Mask lessThan(Float8 a, Float8 b)		{ return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+	static Mask lessOrEqual(Float8 a, Float8 b)		{ return _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ); }
+	static Mask greaterOrEqual(Float8 a, Float8 b)	{ return _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ); }
+	static Mask greaterThan(Float8 a, Float8 b)		{ return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); }
+	static Mask both(Mask a, Mask b)				{ return _mm256_and_ps(a, b); }
+
+	static Float8 select(Mask mask, Float8 a, Float8 b)
+	{
+		return _mm256_blendv_ps(b.v, a.v, mask);
+	}
+};
+
+using FloatVector = Float8;
+#else
+using FloatVector = Float4;
+#endif
@@ -0,0 +1,80 @@
+#include "SmoothedParameters.h"
+
+#include <algorithm>
+#include <cmath>
+
+constexpr int SmoothedParameters::maxParameters;
+
+SmoothedParameters::SmoothedParameters()
+: rampFrames	{0}
+, unsettled		{0}
+{
+	std::fill(current, current + maxParameters, 0.0f);
+	std::fill(target, target + maxParameters, 0.0f);
+	std::fill(start, start + maxParameters, 0.0f);
+	std::fill(rate, rate + maxParameters, 0.0f);
+}
+
+void SmoothedParameters::prepare(float sampleRate, float rampMs)
+{
+	rampFrames = std::max(0.0f, rampMs * sampleRate / 1000.0f);
+}
+
+void SmoothedParameters::reset()
+{
+	std::copy(target, target + maxParameters, current);
+	std::copy(target, target + maxParameters, start);
+	unsettled = 0;
+}
+
+void SmoothedParameters::setTarget(int index, float value)
+{
+	if(index < 0 || index >= maxParameters || value == target[index])
+	{
+		return;
+	}
+
+	target[index] = value;
+
+	// the next advance() sets start to match, so the jump still shows up as a steady block
+	if(rampFrames < 1.0f)
+	{
+		current[index] = value;
+	}
+
+	// a new target mid ramp starts a fresh ramp from wherever it has got to
+	rate[index] = std::abs(value - current[index]) / std::max(rampFrames, 1.0f);
+	unsettled |= 1u << index;
+}
+
+void SmoothedParameters::advance(int numFrames)
+{
+	const Float4 frames = Float4::splat(static_cast<float>(numFrames));
+	const Float4 zero = Float4::splat(0.0f);
+
+	for(int group = 0; group < numGroups; ++group)
+	{
+		const int shift = group * Float4::size;
+
+		if(((unsettled >> shift) & 0xfu) == 0)
+		{
+			continue;
+		}
+
+		const Float4 was = Float4::load(current + shift);
+		const Float4 goal = Float4::load(target + shift);
+		const Float4 maxMove = Float4::load(rate + shift) * frames;
+		const Float4 distance = goal - was;
+
+		// the last step lands on the target exactly rather than on was + distance
+		const Float4 moved = was + Float4::min(Float4::max(distance, zero - maxMove), maxMove);
+		const Float4 now = Float4::select(Float4::lessOrEqual(Float4::abs(distance), maxMove), goal, moved);
+
+		was.store(start + shift);
+		now.store(current + shift);
+
+		// a lane that didn't move this block has a steady ramp, and keeps it until the next setTarget()
+		const int steady = Float4::laneBits(Float4::both(Float4::lessOrEqual(was, now), Float4::greaterOrEqual(was, now)));
+		unsettled &= ~(static_cast<uint32_t>(steady) << shift);
+	}
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "SIMD.h"
+
+#include <cstdint>
+
+/*
+ * Where a smoothed parameter goes over one block: from start, its value
+ * before the block, in equal steps to end at the block's last frame. A
+ * parameter that isn't moving has start == end.
+ */
+struct ParameterRamp
+{
+	float start;
+	float end;
+
+	bool isSteady() const
+	{
+		return start == end;
+	}
+
+	float getStep(int numFrames) const
+	{
+		return (end - start) / static_cast<float>(numFrames > 0 ? numFrames : 1);
+	}
+
+	// value at frame (0 based) of the block, with step from getStep()
+	float at(int frame, float step) const
+	{
+		return start + step * static_cast<float>(frame + 1);
+	}
+};
+
+/*
+ * A ParameterRamp a vector of samples at a time, for the block kernels. The
+ * samples are in frames of frameWidth (1, 2 or 4) interleaved channels, every
+ * channel of a frame gets the same value. Each next() is the values for the
+ * following V::size samples, worked out from the frame index rather than
+ * summed, so they don't drift over a long block.
+ */
+template <typename V>
+class RampVector
+{
+public:
+	RampVector(ParameterRamp ramp, int numFrames, int frameWidth, int firstFrame = 0)
+	: start				(V::splat(ramp.start))
+	, step				(V::splat(ramp.getStep(numFrames)))
+	, framesPerVector	(V::splat(static_cast<float>(V::size / frameWidth)))
+	{
+		float lanes[V::size];
+		for(int lane = 0; lane < V::size; ++lane)
+		{
+			lanes[lane] = static_cast<float>(firstFrame + lane / frameWidth + 1);
+		}
+		frame = V::load(lanes);
+	}
+
+	V next()
+	{
+		const V value = start + step * frame;
+		frame = frame + framesPerVector;
+		return value;
+	}
+
+private:
+	V start, step;
+	V frame, framesPerVector;
+};
+
+/*
+ * Current and target values of up to maxParameters continuous parameters,
+ * structure-of-arrays so advance() moves four of them at a time in a Float4.
+ *
+ * A new target is reached linearly over the ramp time whatever the distance,
+ * and advance() turns that into one ParameterRamp per parameter per block.
+ * Parameters that have arrived are flagged settled and their group of four
+ * is skipped entirely, so a bank of mostly still knobs costs next to nothing.
+ *
+ * Indices are the caller's (FXChain uses FXParameterID). Everything here runs
+ * on the audio thread, between blocks.
+ */
+class SmoothedParameters
+{
+public:
+	static constexpr int maxParameters = 16;
+
+	SmoothedParameters();
+
+	// ramps take rampMs from here on; before the first prepare() every change jumps
+	void prepare(float sampleRate, float rampMs);
+
+	// every parameter straight to its target
+	void reset();
+
+	void setTarget(int index, float value);
+
+	// moves every unsettled parameter numFrames frames along, call once per block before reading the ramps
+	void advance(int numFrames);
+
+	// this block's ramp, from the last advance()
+	ParameterRamp getRamp(int index) const
+	{
+		return { start[index], current[index] };
+	}
+
+	bool isSettled(int index) const
+	{
+		return (unsettled & (1u << index)) == 0;
+	}
+
+private:
+	static constexpr int numGroups = maxParameters / Float4::size;
+
+	float current[maxParameters];
+	float target[maxParameters];
+
+	// where current was before the last advance()
+	float start[maxParameters];
+
+	// per frame, so the whole distance takes rampFrames
+	float rate[maxParameters];
+
+	float rampFrames;
+
+	// bit per parameter, groups with none set are skipped
+	uint32_t unsettled;
+};
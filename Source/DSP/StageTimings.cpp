@@ -0,0 +1,206 @@
+#include "StageTimings.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+ #include <x86intrin.h>
+ #define FX_CYCLES_TSC 1
+#elif defined(__aarch64__)
+ #define FX_CYCLES_CNTVCT 1
+#endif
+
+constexpr int TimingHistogram::numBuckets;
+
+static uint64_t steadyNanoseconds()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+uint64_t CycleCounter::now()
+{
+#if FX_CYCLES_TSC
+	return __rdtsc();
+#elif FX_CYCLES_CNTVCT
+	uint64_t ticks;
+	asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+	return ticks;
+#else
+	return steadyNanoseconds();
+#endif
+}
+
+static double measureTicksPerSecond()
+{
+#if FX_CYCLES_TSC
+	const uint64_t startNs = steadyNanoseconds();
+	const uint64_t startTicks = CycleCounter::now();
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	const uint64_t ticks = CycleCounter::now() - startTicks;
+	const uint64_t ns = steadyNanoseconds() - startNs;
+
+	return static_cast<double>(ticks) * 1.0e9 / static_cast<double>(std::max<uint64_t>(ns, 1));
+#elif FX_CYCLES_CNTVCT
+	uint64_t frequency;
+	asm volatile("mrs %0, cntfrq_el0" : "=r"(frequency));
+	return static_cast<double>(frequency);
+#else
+	return 1.0e9;
+#endif
+}
+
+double CycleCounter::getTicksPerSecond()
+{
+	static const double ticksPerSecond = measureTicksPerSecond();
+	return ticksPerSecond;
+}
+
+//==============================================================================
+TimingHistogram::TimingHistogram()
+{
+	clear();
+}
+
+int TimingHistogram::getBucket(uint64_t ticks)
+{
+	if(ticks < 4)
+	{
+		return static_cast<int>(ticks);
+	}
+
+	// the octave, then the next two bits under its top one
+	const int octave = 63 - __builtin_clzll(ticks);
+	const int quarter = static_cast<int>((ticks >> (octave - 2)) & 3);
+
+	return std::min(4 * (octave - 1) + quarter, numBuckets - 1);
+}
+
+uint64_t TimingHistogram::getBucketTop(int bucket)
+{
+	if(bucket < 4)
+	{
+		return static_cast<uint64_t>(bucket);
+	}
+
+	const int octave = bucket / 4 + 1;
+	const uint64_t quarter = static_cast<uint64_t>(bucket % 4);
+
+	return ((5 + quarter) << (octave - 2)) - 1;
+}
+
+void TimingHistogram::add(uint64_t ticks)
+{
+	// only one writer, so plain loads and stores do and nothing waits on a locked add
+	auto& bucket = buckets[getBucket(ticks)];
+	bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+	if(ticks > max.load(std::memory_order_relaxed))
+	{
+		max.store(ticks, std::memory_order_relaxed);
+	}
+}
+
+TimingHistogram::Summary TimingHistogram::summarise(double ticksPerSecond) const
+{
+	uint32_t counts[numBuckets];
+	uint32_t total = 0;
+
+	for(int i = 0; i < numBuckets; ++i)
+	{
+		counts[i] = buckets[i].load(std::memory_order_relaxed);
+		total += counts[i];
+	}
+
+	const uint64_t longest = max.load(std::memory_order_relaxed);
+
+	// the smallest bucket top that has at least fraction of the calls at or under it
+	auto percentile = [&](double fraction)
+	{
+		const double wanted = fraction * total;
+		uint32_t seen = 0;
+
+		for(int i = 0; i < numBuckets; ++i)
+		{
+			seen += counts[i];
+			if(counts[i] > 0 && seen >= wanted)
+			{
+				return std::min(getBucketTop(i), longest) / ticksPerSecond;
+			}
+		}
+
+		return longest / ticksPerSecond;
+	};
+
+	Summary summary;
+	summary.count = total;
+	summary.p50 = total > 0 ? percentile(0.5) : 0.0;
+	summary.p99 = total > 0 ? percentile(0.99) : 0.0;
+	summary.max = longest / ticksPerSecond;
+
+	return summary;
+}
+
+void TimingHistogram::clear()
+{
+	for(auto& bucket : buckets)
+	{
+		bucket.store(0, std::memory_order_relaxed);
+	}
+
+	max.store(0, std::memory_order_relaxed);
+}
+
+//==============================================================================
+StageTimings::StageTimings()
+: overruns	{0}
+{
+}
+
+const char* StageTimings::getName(int section)
+{
+	static const char* const names[NUM_SECTIONS] = { "overdrive", "distortion", "eq", "delay", "parameters", "bypassed", "chain" };
+	return section >= 0 && section < NUM_SECTIONS ? names[section] : "";
+}
+
+std::string StageTimings::format() const
+{
+	const double ticksPerSecond = CycleCounter::getTicksPerSecond();
+
+	std::string text;
+	char line[128];
+
+	std::snprintf(line, sizeof(line), "%-12s %10s %9s %9s %9s\n", "section", "calls", "p50 us", "p99 us", "max us");
+	text += line;
+
+	for(int section = 0; section < NUM_SECTIONS; ++section)
+	{
+		const auto summary = sections[section].summarise(ticksPerSecond);
+
+		std::snprintf(line, sizeof(line), "%-12s %10u %9.1f %9.1f %9.1f\n",
+			getName(section),
+			static_cast<unsigned>(summary.count),
+			summary.p50 * 1.0e6,
+			summary.p99 * 1.0e6,
+			summary.max * 1.0e6);
+		text += line;
+	}
+
+	std::snprintf(line, sizeof(line), "overruns %u\n", static_cast<unsigned>(getOverruns()));
+	text += line;
+
+	return text;
+}
+
+void StageTimings::clear()
+{
+	for(auto& section : sections)
+	{
+		section.clear();
+	}
+
+	overruns.store(0, std::memory_order_relaxed);
+}
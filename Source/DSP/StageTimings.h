@@ -0,0 +1,120 @@
+#pragma once
+
+#include "FXParameters.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/*
+ * The cheapest clock there is for timing code on the audio thread: the time
+ * stamp counter on x86, the virtual counter on 64-bit ARM, steady_clock
+ * nanoseconds anywhere else (32-bit ARM doesn't let user code near its
+ * cycle counter). Ticks only mean something divided by getTicksPerSecond().
+ */
+struct CycleCounter
+{
+	static uint64_t now();
+
+	// measured once against steady_clock where it has to be, which holds the first caller up ~10 ms
+	static double getTicksPerSecond();
+};
+
+//==============================================================================
+/*
+ * Durations in quarter-octave buckets. One thread (the audio thread) adds,
+ * any other can summarise at the same time without locks; a summary can be
+ * a call or two out while they're being added, which doesn't matter for
+ * percentiles. A percentile comes out as the top of its bucket, so it reads
+ * at most a bucket (a quarter) high and never low.
+ */
+class TimingHistogram
+{
+public:
+	struct Summary
+	{
+		uint32_t count;
+
+		// seconds
+		double p50;
+		double p99;
+		double max;
+	};
+
+	TimingHistogram();
+
+	// writer side
+	void add(uint64_t ticks);
+
+	Summary summarise(double ticksPerSecond) const;
+
+	// only while nothing is adding
+	void clear();
+
+private:
+	// four per octave up to 2^40 ticks, longer than anything worth timing here
+	static constexpr int numBuckets = 4 * 40;
+
+	static int getBucket(uint64_t ticks);
+	static uint64_t getBucketTop(int bucket);
+
+	std::atomic<uint32_t> buckets[numBuckets];
+	std::atomic<uint64_t> max;
+};
+
+//==============================================================================
+/*
+ * What FXChain::process() spends its time on, one histogram per section,
+ * each entry the section's total for one process() call. The sections are
+ * the stages, by FXStage, then the rest. Calls that took longer than the
+ * audio they processed lasts are counted as overruns: on the device, that
+ * call alone would have been a dropout.
+ */
+class StageTimings
+{
+public:
+	enum Section
+	{
+		// OVERDRIVE .. DELAY come first
+		PARAMETERS = NUM_STAGES,	// events, plan changes and the knob ramps
+		BYPASSED,					// the oversampling filters of stages that are off, run to keep their latency
+		CHAIN,						// the whole process() call
+		NUM_SECTIONS
+	};
+
+	StageTimings();
+
+	// a string literal, the trace uses the same names
+	static const char* getName(int section);
+
+	TimingHistogram& operator[](int section)
+	{
+		return sections[section];
+	}
+
+	const TimingHistogram& operator[](int section) const
+	{
+		return sections[section];
+	}
+
+	// writer side
+	void addOverrun()
+	{
+		overruns.store(overruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+
+	uint32_t getOverruns() const
+	{
+		return overruns.load(std::memory_order_relaxed);
+	}
+
+	// a table of calls, p50, p99 and max in microseconds, then the overruns; for logs and the GUI
+	std::string format() const;
+
+	// only while nothing is adding
+	void clear();
+
+private:
+	TimingHistogram sections[NUM_SECTIONS];
+	std::atomic<uint32_t> overruns;
+};
@@ -0,0 +1,326 @@
+#include "Trace.h"
+#include "EventQueue.h"
+#include "StageTimings.h"
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <mutex>
+#include <pthread.h>
+#include <thread>
+
+std::atomic<bool> Trace::enabled {false};
+
+struct TraceEvent
+{
+	uint64_t ticks;
+	const char* name;
+	char phase;
+};
+
+// what a TraceThreadBuffer is up to; the writer only reads CLAIMED and RELEASED ones, and frees a released one once it's empty
+enum SlotState
+{
+	FREE,
+	CLAIMING,
+	CLAIMED,
+	RELEASED
+};
+
+// one thread's events; that thread pushes, the writer pops
+struct TraceThreadBuffer
+{
+	EventQueue<TraceEvent, 32768> events;
+	std::atomic<const char*> name {nullptr};
+	std::atomic<uint32_t> dropped {0};
+	std::atomic<int> state {SlotState::FREE};
+
+	// set while CLAIMING, so every thread gets its own row even when it reuses a slot
+	int tid = 0;
+
+	// writer side, what this trace has been told so far
+	const char* announcedName = nullptr;
+	uint32_t reportedDropped = 0;
+};
+
+// plenty for the audio, serial, footswitch, logger and message threads at once; a thread's slot is reused once it exits
+static constexpr int maxThreads = 16;
+
+// static rather than allocated, so a thread claiming one never touches the heap
+static TraceThreadBuffer buffers[maxThreads];
+static std::atomic<int> nextTid {1};
+
+// events from threads that found every slot taken, and how many of them the trace has been told about
+static std::atomic<uint32_t> unbufferedEvents {0};
+static uint32_t reportedUnbuffered = 0;
+
+static thread_local TraceThreadBuffer* threadBuffer = nullptr;
+static thread_local const char* threadName = nullptr;
+
+/*
+ * Hands a thread's slot back when the thread exits. A pthread key rather than
+ * a thread_local with a destructor, since registering that destructor
+ * allocates on the thread's first record, which may be in the audio callback;
+ * setting a key's value doesn't.
+ */
+static void releaseThreadBuffer(void* slot)
+{
+	static_cast<TraceThreadBuffer*>(slot)->state.store(SlotState::RELEASED, std::memory_order_release);
+	threadBuffer = nullptr;
+}
+
+static pthread_key_t makeReleaseKey()
+{
+	pthread_key_t key;
+	pthread_key_create(&key, releaseThreadBuffer);
+	return key;
+}
+
+static const pthread_key_t releaseKey = makeReleaseKey();
+
+// writer side, start() and stop() hold the lock
+static std::mutex writerLock;
+static std::thread writerThread;
+static std::atomic<bool> writing {false};
+static FILE* file = nullptr;
+static bool firstRecord = true;
+static uint64_t startTicks = 0;
+static double ticksPerMicrosecond = 1.0;
+
+// how often the writer empties the rings when there's little in them, well before the audio thread's fills up;
+// when there's more (the offline renderer runs the chain flat out) it comes back after a millisecond
+static constexpr std::chrono::milliseconds writeInterval {10};
+static constexpr std::chrono::milliseconds busyWriteInterval {1};
+static constexpr int busyEvents = 1024;
+
+//==============================================================================
+static TraceThreadBuffer* getThreadBuffer()
+{
+	if(threadBuffer != nullptr)
+	{
+		return threadBuffer;
+	}
+
+	// a thread that found none free looks again next time, one may have been released since
+	for(auto& buffer : buffers)
+	{
+		int expected = SlotState::FREE;
+		if(buffer.state.load(std::memory_order_relaxed) == SlotState::FREE
+			&& buffer.state.compare_exchange_strong(expected, SlotState::CLAIMING, std::memory_order_acquire))
+		{
+			buffer.tid = nextTid.fetch_add(1, std::memory_order_relaxed);
+			buffer.name.store(threadName, std::memory_order_relaxed);
+			buffer.state.store(SlotState::CLAIMED, std::memory_order_release);
+
+			pthread_setspecific(releaseKey, &buffer);
+			threadBuffer = &buffer;
+			break;
+		}
+	}
+
+	return threadBuffer;
+}
+
+void Trace::record(const char* name, char phase)
+{
+	auto* buffer = getThreadBuffer();
+	if(buffer == nullptr)
+	{
+		unbufferedEvents.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	if(!buffer->events.push({ CycleCounter::now(), name, phase }))
+	{
+		buffer->dropped.store(buffer->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+}
+
+void Trace::setThreadName(const char* name)
+{
+	threadName = name;
+
+	if(threadBuffer != nullptr)
+	{
+		threadBuffer->name.store(name, std::memory_order_relaxed);
+	}
+}
+
+//==============================================================================
+static void writeRecord(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
+static void writeRecord(const char* format, ...)
+{
+	fputs(firstRecord ? "" : ",\n", file);
+	firstRecord = false;
+
+	va_list args;
+	va_start(args, format);
+	vfprintf(file, format, args);
+	va_end(args);
+}
+
+static double toMicroseconds(uint64_t ticks)
+{
+	return ticks > startTicks ? static_cast<double>(ticks - startTicks) / ticksPerMicrosecond : 0.0;
+}
+
+// back to FREE for the next thread, with nothing of the last one's left
+static void freeSlot(TraceThreadBuffer& buffer)
+{
+	buffer.name.store(nullptr, std::memory_order_relaxed);
+	buffer.dropped.store(0, std::memory_order_relaxed);
+	buffer.announcedName = nullptr;
+	buffer.reportedDropped = 0;
+
+	buffer.state.store(SlotState::FREE, std::memory_order_release);
+}
+
+// how many events it wrote
+static int writeEvents()
+{
+	int written = 0;
+
+	for(auto& buffer : buffers)
+	{
+		// read before the events, so a RELEASED slot's last events are all in by now
+		const int state = buffer.state.load(std::memory_order_acquire);
+		if(state != SlotState::CLAIMED && state != SlotState::RELEASED)
+		{
+			continue;
+		}
+
+		const int tid = buffer.tid;
+
+		const char* name = buffer.name.load(std::memory_order_relaxed);
+		if(name != nullptr && name != buffer.announcedName)
+		{
+			writeRecord("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", tid, name);
+			buffer.announcedName = name;
+		}
+
+		uint64_t lastTicks = startTicks;
+
+		while(const TraceEvent* event = buffer.events.peek())
+		{
+			lastTicks = event->ticks;
+
+			// instants are scoped to their thread, the default would draw them across the whole process
+			writeRecord("{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d%s}",
+				event->name,
+				event->phase,
+				toMicroseconds(event->ticks),
+				tid,
+				event->phase == 'i' ? ",\"s\":\"t\"" : "");
+
+			buffer.events.pop();
+			++written;
+		}
+
+		const uint32_t dropped = buffer.dropped.load(std::memory_order_relaxed);
+		if(dropped != buffer.reportedDropped)
+		{
+			writeRecord("{\"name\":\"trace dropped events\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"count\":%u}}",
+				toMicroseconds(lastTicks),
+				tid,
+				static_cast<unsigned>(dropped - buffer.reportedDropped));
+			buffer.reportedDropped = dropped;
+		}
+
+		// the thread has exited and everything it recorded is written out
+		if(state == SlotState::RELEASED)
+		{
+			freeSlot(buffer);
+		}
+	}
+
+	const uint32_t unbuffered = unbufferedEvents.load(std::memory_order_relaxed);
+	if(unbuffered != reportedUnbuffered)
+	{
+		writeRecord("{\"name\":\"trace dropped events, every thread buffer taken\",\"ph\":\"i\",\"s\":\"p\",\"ts\":%.3f,\"pid\":1,\"tid\":0,\"args\":{\"count\":%u}}",
+			toMicroseconds(CycleCounter::now()),
+			static_cast<unsigned>(unbuffered - reportedUnbuffered));
+		reportedUnbuffered = unbuffered;
+	}
+
+	fflush(file);
+	return written;
+}
+
+static void writerLoop()
+{
+	while(writing.load(std::memory_order_relaxed))
+	{
+		const int written = writeEvents();
+		std::this_thread::sleep_for(written < busyEvents ? writeInterval : busyWriteInterval);
+	}
+}
+
+bool Trace::start(const char* path)
+{
+	std::lock_guard<std::mutex> lock(writerLock);
+
+	if(file != nullptr || (file = fopen(path, "w")) == nullptr)
+	{
+		return false;
+	}
+
+	// anything left over from an earlier trace goes, this one starts clean
+	for(auto& buffer : buffers)
+	{
+		const int state = buffer.state.load(std::memory_order_acquire);
+		if(state != SlotState::CLAIMED && state != SlotState::RELEASED)
+		{
+			continue;
+		}
+
+		while(buffer.events.peek() != nullptr)
+		{
+			buffer.events.pop();
+		}
+
+		if(state == SlotState::RELEASED)
+		{
+			freeSlot(buffer);
+			continue;
+		}
+
+		buffer.announcedName = nullptr;
+		buffer.reportedDropped = buffer.dropped.load(std::memory_order_relaxed);
+	}
+
+	reportedUnbuffered = unbufferedEvents.load(std::memory_order_relaxed);
+
+	ticksPerMicrosecond = CycleCounter::getTicksPerSecond() / 1.0e6;
+	startTicks = CycleCounter::now();
+
+	// the JSON array form, which the viewers still read if the closing bracket never got written
+	fputs("[\n", file);
+	firstRecord = true;
+
+	writing = true;
+	writerThread = std::thread(writerLoop);
+
+	enabled.store(true, std::memory_order_relaxed);
+	return true;
+}
+
+void Trace::stop()
+{
+	std::lock_guard<std::mutex> lock(writerLock);
+
+	if(file == nullptr)
+	{
+		return;
+	}
+
+	enabled.store(false, std::memory_order_relaxed);
+
+	writing = false;
+	writerThread.join();
+
+	writeEvents();
+	fputs("\n]\n", file);
+	fclose(file);
+	file = nullptr;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+
+/*
+ * Opt-in timeline of what every thread is doing, for chrome://tracing or
+ * ui.perfetto.dev. Threads record begin, end and instant events into their
+ * own wait-free ring, claimed from a fixed pool the first time the thread
+ * records (nothing is allocated there, so the audio thread can trace too),
+ * and a background thread started by start() writes them out as Chrome trace
+ * JSON every few tens of milliseconds. A ring that fills up before it's
+ * written out drops events and says how many in the trace. A thread's ring
+ * goes back to the pool once the thread has exited and its last events are
+ * written; events from a thread that finds the pool empty are counted in the
+ * trace too, and it gets the next ring that comes free.
+ *
+ * While tracing is off, recording costs one relaxed load. Names must be
+ * string literals, or otherwise outlive the trace.
+ */
+class Trace
+{
+public:
+	static bool isEnabled()
+	{
+		return enabled.load(std::memory_order_relaxed);
+	}
+
+	static void begin(const char* name)
+	{
+		if(isEnabled())
+		{
+			record(name, 'B');
+		}
+	}
+
+	static void end(const char* name)
+	{
+		if(isEnabled())
+		{
+			record(name, 'E');
+		}
+	}
+
+	static void instant(const char* name)
+	{
+		if(isEnabled())
+		{
+			record(name, 'i');
+		}
+	}
+
+	// what the calling thread is called in the trace, from its next record on; cheap enough to call every block
+	static void setThreadName(const char* name);
+
+	// opens path and starts writing to it; false if it can't be opened or a trace is already running
+	static bool start(const char* path);
+
+	// writes out what's left and closes the file
+	static void stop();
+
+private:
+	static void record(const char* name, char phase);
+
+	static std::atomic<bool> enabled;
+};
+
+// begin on construction, end on destruction
+class TraceScope
+{
+public:
+	explicit TraceScope(const char* scopeName)
+	: name(scopeName)
+	{
+		Trace::begin(name);
+	}
+
+	~TraceScope()
+	{
+		Trace::end(name);
+	}
+
+private:
+	const char* name;
+};
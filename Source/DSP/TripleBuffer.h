@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+/*
+ * Wait-free handoff of a whole object from one writer thread to one reader
+ * (the audio thread). The writer fills getWriteBuffer() and calls publish(),
+ * the reader calls acquire() at a block boundary and keeps using what it
+ * returns until the next acquire(). Neither side ever waits for the other and
+ * the writer can publish as often as it likes, the reader only sees the latest.
+ */
+template <typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer()
+	: back{0}
+	, middle{1}
+	, front{2}
+	{}
+
+	// writer side
+	T& getWriteBuffer()
+	{
+		return buffers[back];
+	}
+
+	void publish()
+	{
+		back = middle.exchange(back | dirtyBit, std::memory_order_acq_rel) & indexMask;
+	}
+
+	// reader side, returns the newest published object (or the same one again if nothing new)
+	const T& acquire()
+	{
+		bool changed;
+		return acquire(changed);
+	}
+
+	// as above, and says whether something new came in
+	const T& acquire(bool& changed)
+	{
+		changed = (middle.load(std::memory_order_relaxed) & dirtyBit) != 0;
+
+		if(changed)
+		{
+			front = middle.exchange(front, std::memory_order_acq_rel) & indexMask;
+		}
+
+		return buffers[front];
+	}
+
+	const T& getReadBuffer() const
+	{
+		return buffers[front];
+	}
+
+	// the reader owns what acquire() returned until its next acquire(), so it may edit it in place
+	T& getReadBuffer()
+	{
+		return buffers[front];
+	}
+
+	// only safe while neither side is running, e.g. in prepare()
+	template <typename Function>
+	void forEach(Function function)
+	{
+		for(auto& buffer : buffers)
+		{
+			function(buffer);
+		}
+	}
+
+private:
+	static constexpr int dirtyBit = 4;
+	static constexpr int indexMask = 3;
+
+	std::array<T, 3> buffers;
+
+	int back;
+	std::atomic<int> middle;
+	int front;
+};
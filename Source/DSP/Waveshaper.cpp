@@ -0,0 +1,115 @@
+#include "Waveshaper.h"
+
+float fastAtan(float x)
+{
+	float lanes[Float4::size] = { x };
+	atanVector(Float4::load(lanes)).store(lanes);
+	return lanes[0];
+}
+
+//==============================================================================
+// runs kernel over the buffer a vector at a time, the ragged end goes through a padded vector
+template <typename V, typename Kernel>
+static inline void processBlock(float* buffer, int numSamples, Kernel kernel)
+{
+	int i = 0;
+	for(; i + V::size <= numSamples; i += V::size)
+	{
+		kernel(V::load(buffer + i)).store(buffer + i);
+	}
+
+	if(i < numSamples)
+	{
+		float tail[V::size] = {};
+		const int remaining = numSamples - i;
+
+		for(int j = 0; j < remaining; ++j)
+		{
+			tail[j] = buffer[i + j];
+		}
+
+		kernel(V::load(tail)).store(tail);
+
+		for(int j = 0; j < remaining; ++j)
+		{
+			buffer[i + j] = tail[j];
+		}
+	}
+}
+
+void overdriveBlock(float* buffer, int numSamples, float blend, float vol)
+{
+	using V = FloatVector;
+
+	const V vBlend = V::splat(blend);
+	const V vDry = V::splat(1.0f - blend);
+	const V vVol = V::splat(vol);
+
+	processBlock<V>(buffer, numSamples, [&](V x)
+	{
+		return overdriveVector(x, vBlend, vDry, vVol);
+	});
+}
+
+void distortionBlock(float* buffer, int numSamples, float drive, float blend, float tone, float vol)
+{
+	using V = FloatVector;
+
+	const V vGain = V::splat(drive * tone);
+	const V vWet = V::splat(static_cast<float>(2.0f / PI) * blend);
+	const V vDry = V::splat(1.0f - blend);
+	const V vVol = V::splat(vol);
+
+	processBlock<V>(buffer, numSamples, [&](V x)
+	{
+		return distortionVector(x, vGain, vWet, vDry, vVol);
+	});
+}
+
+void overdriveBlock(float* buffer, int numSamples, ParameterRamp blend, ParameterRamp vol, int frameWidth)
+{
+	using V = FloatVector;
+
+	if(blend.isSteady() && vol.isSteady())
+	{
+		overdriveBlock(buffer, numSamples, blend.start, vol.start);
+		return;
+	}
+
+	const int numFrames = numSamples / frameWidth;
+	RampVector<V> vBlend(blend, numFrames, frameWidth);
+	RampVector<V> vVol(vol, numFrames, frameWidth);
+
+	const V one = V::splat(1.0f);
+
+	processBlock<V>(buffer, numSamples, [&](V x)
+	{
+		const V b = vBlend.next();
+		return overdriveVector(x, b, one - b, vVol.next());
+	});
+}
+
+void distortionBlock(float* buffer, int numSamples, ParameterRamp gain, ParameterRamp blend, ParameterRamp vol, int frameWidth)
+{
+	using V = FloatVector;
+
+	if(gain.isSteady() && blend.isSteady() && vol.isSteady())
+	{
+		distortionBlock(buffer, numSamples, gain.start, blend.start, 1.0f, vol.start);
+		return;
+	}
+
+	const int numFrames = numSamples / frameWidth;
+	RampVector<V> vGain(gain, numFrames, frameWidth);
+	RampVector<V> vBlend(blend, numFrames, frameWidth);
+	RampVector<V> vVol(vol, numFrames, frameWidth);
+
+	const V wetScale = V::splat(static_cast<float>(2.0f / PI));
+	const V one = V::splat(1.0f);
+
+	processBlock<V>(buffer, numSamples, [&](V x)
+	{
+		const V b = vBlend.next();
+		return distortionVector(x, vGain.next(), wetScale * b, one - b, vVol.next());
+	});
+}
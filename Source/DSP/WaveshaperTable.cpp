@@ -0,0 +1,129 @@
+#include "WaveshaperTable.h"
+#include "BiQuad.h" // PI
+
+#include <algorithm>
+#include <cmath>
+
+constexpr int WaveshaperTable::numIntervals;
+constexpr float WaveshaperTable::inputRange;
+
+static constexpr float indexScale = WaveshaperTable::numIntervals / (2.0f * WaveshaperTable::inputRange);
+
+WaveshaperTable::WaveshaperTable()
+: curve			{ShaperCurve::CLASSIC}
+, interpolation	{TableInterpolation::CUBIC}
+{
+	table.fill(0.0f);
+}
+
+float WaveshaperTable::evaluateCurve(ShaperCurve curve, float shape, float x)
+{
+	switch(curve)
+	{
+		case ShaperCurve::TUBE:
+		{
+			// biased tanh, the offset brings in even harmonics like a single ended stage
+			const float bias = 0.4f * shape;
+			return std::tanh(x + bias) - std::tanh(bias);
+		}
+		case ShaperCurve::FUZZ:
+		{
+			// exponential clipper, gets harder and squarer as shape goes up
+			const float hardness = 1.0f + 4.0f * shape;
+			const float magnitude = 1.0f - std::exp(-std::fabs(x) * hardness);
+			return x < 0.0f ? -magnitude : magnitude;
+		}
+		case ShaperCurve::ASYMMETRIC_CLIP:
+		{
+			// soft knee on the positive half, hard clip on the negative half at a lower level
+			if(x >= 0.0f)
+			{
+				return x / (1.0f + x);
+			}
+			const float floor = -(1.0f - 0.5f * shape);
+			return std::max(x, floor);
+		}
+		case ShaperCurve::CLASSIC:
+		default:
+			return (2.0f / PI) * std::atan(x);
+	}
+}
+
+void WaveshaperTable::build(ShaperCurve newCurve, float shape, TableInterpolation newInterpolation)
+{
+	curve = newCurve;
+	interpolation = newInterpolation;
+
+	// table[1] sits at -inputRange and table[numIntervals + 1] at +inputRange
+	for(int i = 0; i < numIntervals + 3; ++i)
+	{
+		const float x = (i - 1) / indexScale - inputRange;
+		table[i] = evaluateCurve(curve, shape, x);
+	}
+}
+
+float WaveshaperTable::lookup(float x, TableInterpolation interpolation) const
+{
+	float position = (std::min(std::max(x, -inputRange), inputRange) + inputRange) * indexScale;
+
+	// the last interval is only ever entered at exactly +inputRange
+	int index = std::min(static_cast<int>(position), numIntervals - 1);
+	float t = position - index;
+
+	const float* p = table.data() + index + 1;
+
+	if(interpolation == TableInterpolation::LINEAR)
+	{
+		return p[0] + t * (p[1] - p[0]);
+	}
+
+	// Catmull-Rom through p[-1], p[0], p[1], p[2]
+	const float a = 0.5f * (p[1] - p[-1]);
+	const float b = p[-1] - 2.5f * p[0] + 2.0f * p[1] - 0.5f * p[2];
+	const float c = 0.5f * (p[2] - p[-1]) + 1.5f * (p[0] - p[1]);
+
+	return p[0] + t * (a + t * (b + t * c));
+}
+
+void WaveshaperTable::process(float* buffer, int numSamples, float preGain, float blend, float vol) const
+{
+	// steady ramps come out exactly as the fixed values
+	process(buffer, numSamples, { preGain, preGain }, { blend, blend }, { vol, vol }, 1);
+}
+
+void WaveshaperTable::process(float* buffer, int numSamples, ParameterRamp preGain, ParameterRamp blend, ParameterRamp vol, int frameWidth) const
+{
+	// the interpolation choice is hoisted so each loop stays branch-free
+	if(interpolation == TableInterpolation::LINEAR)
+	{
+		processFrames<TableInterpolation::LINEAR>(buffer, numSamples, preGain, blend, vol, frameWidth);
+	}
+	else
+	{
+		processFrames<TableInterpolation::CUBIC>(buffer, numSamples, preGain, blend, vol, frameWidth);
+	}
+}
+
+template <TableInterpolation Interpolation>
+void WaveshaperTable::processFrames(float* buffer, int numSamples, ParameterRamp preGain, ParameterRamp blend, ParameterRamp vol, int frameWidth) const
+{
+	const int numFrames = numSamples / frameWidth;
+	const float gainStep = preGain.getStep(numFrames);
+	const float blendStep = blend.getStep(numFrames);
+	const float volStep = vol.getStep(numFrames);
+
+	for(int frame = 0; frame < numFrames; ++frame)
+	{
+		const float g = preGain.at(frame, gainStep);
+		const float b = blend.at(frame, blendStep);
+		const float dry = 1.0f - b;
+		const float v = vol.at(frame, volStep);
+
+		float* samples = buffer + frame * frameWidth;
+		for(int channel = 0; channel < frameWidth; ++channel)
+		{
+			const float x = samples[channel];
+			samples[channel] = (b * lookup(g * x, Interpolation) + dry * x) * v;
+		}
+	}
+}
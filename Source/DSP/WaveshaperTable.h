@@ -0,0 +1,71 @@
+#pragma once
+
+#include "SmoothedParameters.h"
+
+#include <array>
+
+enum ShaperCurve
+{
+	CLASSIC, // 0, the original atan distortion, computed rather than looked up
+	TUBE,
+	FUZZ,
+	ASYMMETRIC_CLIP,
+	NUM_CURVES
+};
+
+enum TableInterpolation
+{
+	LINEAR,
+	CUBIC
+};
+
+/*
+ * A transfer curve sampled into a table, evaluated with linear or 4 point
+ * (Catmull-Rom) interpolation. Building the table does the expensive math and
+ * belongs on a control thread; evaluating it is one table read per sample no
+ * matter how complicated the curve is.
+ *
+ * All the curves saturate, so inputs beyond +-inputRange are clamped to the ends.
+ * 1024 intervals x 4 bytes keeps the whole table inside the Pi's L1 cache.
+ */
+class WaveshaperTable
+{
+public:
+	static constexpr int numIntervals = 1024;
+	static constexpr float inputRange = 8.0f;
+
+	WaveshaperTable();
+
+	// shape is 0..1 and means something a little different per curve (bias, hardness, asymmetry)
+	void build(ShaperCurve curve, float shape, TableInterpolation interpolation = TableInterpolation::CUBIC);
+
+	ShaperCurve getCurve() const
+	{
+		return curve;
+	}
+
+	TableInterpolation getInterpolation() const
+	{
+		return interpolation;
+	}
+
+	float lookup(float x, TableInterpolation interpolation) const;
+
+	// buffer = (blend * table(preGain * x) + (1 - blend) * x) * vol, in place
+	void process(float* buffer, int numSamples, float preGain, float blend, float vol) const;
+
+	// the same with the three moving across numSamples, whole frames of frameWidth interleaved channels
+	void process(float* buffer, int numSamples, ParameterRamp preGain, ParameterRamp blend, ParameterRamp vol, int frameWidth) const;
+
+	static float evaluateCurve(ShaperCurve curve, float shape, float x);
+
+private:
+	template <TableInterpolation Interpolation>
+	void processFrames(float* buffer, int numSamples, ParameterRamp preGain, ParameterRamp blend, ParameterRamp vol, int frameWidth) const;
+
+	ShaperCurve curve;
+	TableInterpolation interpolation;
+
+	// one guard point either side so cubic interpolation never reads outside
+	std::array<float, numIntervals + 3> table;
+};
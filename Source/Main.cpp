@@ -1,5 +1,6 @@
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "MainComponent.h"
+#include "DSP/Trace.h"
 
 //==============================================================================
 class FXProcessorApplication  : public JUCEApplication
@@ -15,12 +16,27 @@ public:
     //==============================================================================
     void initialise (const String& commandLine) override
     {
+        // --trace file.json records every thread as a Chrome trace until the app quits
+        auto args = StringArray::fromTokens (commandLine, true);
+        auto traceIndex = args.indexOf ("--trace");
+
+        if (traceIndex >= 0 && traceIndex + 1 < args.size())
+        {
+            auto traceFile = File::getCurrentWorkingDirectory().getChildFile (args[traceIndex + 1].unquoted());
+
+            if (! Trace::start (traceFile.getFullPathName().toRawUTF8()))
+                DBG ("Can't write trace to " + traceFile.getFullPathName());
+        }
+
         mainWindow.reset (new MainWindow (getApplicationName()));
     }
 
     void shutdown() override
     {
         mainWindow = nullptr; // (deletes our window)
+
+        // the audio has stopped with the window, so the trace has everything
+        Trace::stop();
     }
 
     //==============================================================================
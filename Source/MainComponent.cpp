@@ -1,6 +1,6 @@
-#include <stdio.h>
-
 #include "MainComponent.h"
+#include "DSP/RealtimeCheck.h"
+#include "DSP/Trace.h"
 
 MainComponent::MainComponent()
 : audioSetupComp (
@@ -14,22 +14,11 @@ MainComponent::MainComponent()
     false,
     false
   )
-, odBlend(0.5f)
-, odVol(1.0f)
-, distDrive(0.5f)
-, distBlend(0.5f)
-, distTone(900.0f)
-, distVol(1.0f)
-, delayMS(0.0f)
-, feedback(0.0f)
-, wet(0.0f)
-, lowVol(0.0f)
-, highVol(0.0f)
-, lowFreq(100.0f)
-, highFreq(1000.0f)
+, serialControl(parameters, logger)
 {
     // set up gui
     addAndMakeVisible(audioSetupComp);
+    addAndMakeVisible(timingsBox);
     addAndMakeVisible(diagnosticsBox);
 
     diagnosticsBox.setMultiLine(true);
@@ -42,39 +31,48 @@ MainComponent::MainComponent()
     diagnosticsBox.setColour(TextEditor::outlineColourId,    Colour (0x1c000000));
     diagnosticsBox.setColour(TextEditor::shadowColourId,     Colour (0x16000000));
 
+    timingsBox.setMultiLine(true);
+    timingsBox.setReadOnly(true);
+    timingsBox.setCaretVisible(false);
+    timingsBox.setFont(Font(Font::getDefaultMonospacedFontName(), 11.0f, Font::plain));
+    timingsBox.setColour(TextEditor::backgroundColourId, Colour (0x32ffffff));
+    timingsBox.setColour(TextEditor::outlineColourId,    Colour (0x1c000000));
+
     cpuUsageLabel.setText("CPU Usage", dontSendNotification);
     cpuUsageText.setJustificationType(Justification::right);
     addAndMakeVisible(&cpuUsageLabel);
     addAndMakeVisible(&cpuUsageText);
 
-    setSize(760, 360);
+    setSize(900, 480);
+
+    // per stage timings for the stats box, measured on the audio thread and read from the timer
+    fxChain.setTimingEnabled(true);
+
+    // the chain layout follows the footswitches, rebuilt on their thread rather than the audio one
+    footswitchesChanged(footswitches.getSwitchMask());
+    footswitches.setListener(this);
+
+    // likewise the EQ design follows the serial controls on their thread, from the defaults on
+    fxChain.setEQParameters(parameters.getParameters());
+    serialControl.setListener(this);
 
     // audio device initialization
     setAudioChannels(2, 2);
     deviceManager.addChangeListener(this);
 
-    // setup raspberry pi GPIO
-    wiringPiSetup();
-    pinMode(SWITCH1, INPUT);
-    pullUpDnControl(SWITCH1, PUD_UP);
-    pinMode(SWITCH2, INPUT);
-    pullUpDnControl(SWITCH2, PUD_UP);
-    pinMode(SWITCH3, INPUT);
-    pullUpDnControl(SWITCH3, PUD_UP);
-    pinMode(SWITCH4, INPUT);
-    pullUpDnControl(SWITCH4, PUD_UP);
-   
-    // set up serial communication
-    if((serialPort = serialOpen("/dev/serial0", 9600)) < 0)
-    {
-        DBG("Error opening serial port\n");
-    }
+    // footswitches, serial parameters and console logging live on their own threads
+    footswitches.startThread();
+    logger.startThread();
+    serialControl.startThread();
 
     startTimer(50);
 }
 
 MainComponent::~MainComponent()
 {
+    serialControl.stopThread(1000);
+    logger.stopThread(1000);
+    footswitches.stopThread(1000);
     deviceManager.removeChangeListener(this);
     shutdownAudio();
 }
@@ -82,65 +80,25 @@ MainComponent::~MainComponent()
 //==============================================================================
 void MainComponent::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
 {
-    delayLine.updateParameters(
-        delayMS,
-        feedback,
-        wet,
-        sampleRate
-    );
-    delayLine.prepareBuffer(sampleRate);
-
-    lowBand.reset();
-    highBand.reset();
-}
-
-static constexpr float onethird = 1.0f / 3.0f;
-static constexpr float twothird = 2.0f / 3.0f;
-
-float MainComponent::overdrive(float sample, float blend, float vol)
-{
-    float outSample = sample;
-    
-    if(sample >= 0.0f && sample < onethird) 
-    {
-        outSample *= 2.0f; 
-    }
-
-    if(sample >= onethird && sample < twothird)
-    {
-        outSample = 3.0f - powf((2.0f - (3.0f * sample)), 2.0f);
-        outSample /= 3.0f;
-    }
-
-    if(sample >= twothird && sample <= 1.0f)
+    // one chain for every active output, up to what it can carry in its SIMD lanes
+    auto numChannels = 1;
+    if(auto* device = deviceManager.getCurrentAudioDevice())
     {
-        outSample = 1.0f;
+        numChannels = jlimit(1, FXChain::maxChannels, device->getActiveOutputChannels().countNumberOfSetBits());
     }
 
-    outSample = (blend * outSample + (1 - blend) * sample) * vol;
-
-    return outSample;
+    fxChain.setParameters(parameters.getParameters());
+    fxChain.prepare(sampleRate, samplesPerBlockExpected, numChannels);
 }
 
-//static constexpr float PI = 3.14159;
-
-float MainComponent::distortion(float sample, float drive, float blend, float tone, float vol)
+void MainComponent::getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill)
 {
-    float outSample;
-    float temp = sample;
-
-    temp *= drive * tone;
-
-    outSample = (((2.0f / PI ) * atan(temp) * blend) + (sample * (1.0f - blend))) * vol;
-    
-    return outSample;
-}
+    // in FX_REALTIME_CHECK builds, anything in here that allocates, locks, does I/O or sleeps is reported
+    RealtimeScope realtime;
 
-// only gonna do mono for now
-#define channel 0
+    Trace::setThreadName("audio");
+    TraceScope scope("audio callback");
 
-void MainComponent::getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill)
-{
     // get current device
     auto* device = deviceManager.getCurrentAudioDevice();
 
@@ -150,70 +108,21 @@ void MainComponent::getNextAudioBlock (const AudioSourceChannelInfo& bufferToFil
     auto maxInputChannels = activeInputChannels.countNumberOfSetBits();
     auto maxOutputChannels = activeOutputChannels.countNumberOfSetBits();
 
-    if(serialDataAvail(serialPort))
-    {
-        updateFXParam(); 
-        
-        delayLine.updateParameters(
-            delayMS,
-            feedback,
-            wet,
-            device->getCurrentSampleRate()
-        );
-
-        lowBand.calculateCoefficients(device->getCurrentSampleRate(), lowFreq, lowVol);
-        highBand.calculateCoefficients(device->getCurrentSampleRate(), highFreq, highVol);
-    }
+    // changes normally come stamped through the chain's event queue, these are what didn't fit and land here at the block start
+    const auto dirtyStages = parameters.takeDirtyStages();
 
-    if((!activeOutputChannels[0]) || maxInputChannels == 0) 
+    if(dirtyStages != 0)
     {
-        bufferToFill.buffer->clear(0, bufferToFill.startSample, bufferToFill.numSamples);
+        fxChain.setParameters(parameters.getParameters(), dirtyStages);
     }
-    else
-    {
-        if(!activeInputChannels[0])
-        {
-            bufferToFill.buffer->clear(0, bufferToFill.startSample, bufferToFill.numSamples);
-        }
-        else
-        {
-            auto* audioData = bufferToFill.buffer->getWritePointer(0, bufferToFill.startSample);
-            
-            if(digitalRead(SWITCH1) || digitalRead(SWITCH2))
-            {
-                for(auto sample = 0; sample < bufferToFill.numSamples; ++sample)
-                {
-                    if(digitalRead(SWITCH1) == HIGH)
-                    { 
-                        audioData[sample] = overdrive(audioData[sample], odBlend, odVol);
-                    }
-                    if(digitalRead(SWITCH2) == HIGH)
-                    {
-                        audioData[sample] = distortion(audioData[sample], distDrive, distBlend, distTone, distVol);
-                    }
-                }
-            }
 
-            if(digitalRead(SWITCH3))
-            {
-                lowBand.process(audioData, bufferToFill.numSamples);
-                highBand.process(audioData, bufferToFill.numSamples);
-            }
-           
-            if(digitalRead(SWITCH4))
-            {
-                delayLine.process(audioData, bufferToFill.numSamples);
-            }
-        }
-    }
+    // every active output runs through the chain, together so it can process them side by side
+    float* channels[FXChain::maxChannels];
+    auto numChannels = 0;
 
-    /* 
-     * This is still here for reference
-
-    // handle processing and what not
     for(auto channel = 0; channel < maxOutputChannels; ++channel)
     {
-        if((!activeOutputChannels[channel]) || maxInputChannels == 0) 
+        if((!activeOutputChannels[channel]) || maxInputChannels == 0 || numChannels == fxChain.getNumChannels()) 
         {
             bufferToFill.buffer->clear(channel, bufferToFill.startSample, bufferToFill.numSamples);
         }
@@ -222,292 +131,23 @@ void MainComponent::getNextAudioBlock (const AudioSourceChannelInfo& bufferToFil
             // in case there is more output channels than input
             auto actualInputChannel = channel % maxInputChannels;
 
-            if(!activeInputChannels[channel])
+            if(!activeInputChannels[actualInputChannel])
             {
                 bufferToFill.buffer->clear(channel, bufferToFill.startSample, bufferToFill.numSamples);
             }
             else
             {
-                auto* input = bufferToFill.buffer->getWritePointer(actualInputChannel, bufferToFill.startSample);
-                auto* output = bufferToFill.buffer->getWritePointer(channel, bufferToFill.startSample);
-
-                if(digitalRead(SWITCH1) || digitalRead(SWITCH2))
+                if(actualInputChannel != channel)
                 {
-                    for(auto sample = 0; sample < bufferToFill.numSamples; ++sample)
-                    {
-                        if(digitalRead(SWITCH1) == HIGH)
-                        { 
-                            output[sample] = overdrive(input[sample], odBlend, odVol);
-                        }
-                        if(digitalRead(SWITCH2) == HIGH)
-                        {
-                            output[sample] = distortion(input[sample], distDrive, distBlend, distTone, distVol);
-                        }
-                    }
+                    bufferToFill.buffer->copyFrom(channel, bufferToFill.startSample, *bufferToFill.buffer, actualInputChannel, bufferToFill.startSample, bufferToFill.numSamples);
                 }
-                
-                delayLine.process(output, bufferToFill.numSamples);
-            }
-        }
-    }
-    */
-}
-
-
-// this is not final! 
-// this is just for a quick prototype to test and show a functioning product
-void MainComponent::updateFXParam()
-{
-    serialData = serialGetchar(serialPort);
-
-    // debugging
-//    printf("%c", serialData);
-//    fflush(stdout);
-
-    // overdrive params
-    switch(serialData)
-    {
-        case 'q':
-        {
-            odVol += 0.25f;
-            printf("odVol: %.4f\n", odVol);
-            fflush(stdout);
-            break;
-        }
-        case 'a':
-        {
-            odVol -= 0.25f;
-            printf("odVol: %.4f\n", odVol);
-            fflush(stdout);
-            break;
-        }
-        case 'w':
-        {
-            odBlend += 0.125;
-            printf("odBlend: %.4f\n", odBlend);
-            fflush(stdout);
-            break;
-        }
-        case 's':
-        {
-            odBlend -= 0.125;
-            printf("odBlend: %.4f\n", odBlend);
-            fflush(stdout);
-            break;
-        }
-    }
-
-    // distortion params
-    switch(serialData)
-    {
-        case 'o':
-        {
-            distVol += 0.25f;
-            printf("distVol: %.4f\n", distVol);
-            fflush(stdout);
-            break;
-        }
-        case 'l':
-        {
-            distVol -= 0.25f;
-            printf("distVol: %.4f\n", distVol);
-            fflush(stdout);
-            break;
-        }
-        case 'i':
-        {
-            distBlend += 0.125;
-            printf("distBlend: %.4f\n", distBlend);
-            fflush(stdout);
-            break;
-        }
-        case 'k':
-        {
-            distBlend -= 0.125;
-            printf("distBlend: %.4f\n", distBlend);
-            fflush(stdout);
-            break;
-        }
-        case 'u':
-        {
-            distTone += 25.0;
-            printf("distTone: %.4f\n", distTone);
-            fflush(stdout);
-            break;
-        }
-        case 'j':
-        {
-            distTone -= 25.0;
-            printf("distTone: %.4f\n", distTone);
-            fflush(stdout);
-            break;
-        }
-        case 'y':
-        {
-            distDrive += 0.125;
-            printf("distDrive: %.4f\n", distDrive);
-            fflush(stdout);
-            break;
-        }
-        case 'h':
-        {
-            distDrive -= 0.125;
-            printf("distDrive: %.4f\n", distDrive);
-            fflush(stdout);
-            break;
-        }
-    }
-   
-    // delay param
-    switch(serialData)
-    {
-        case 'e':
-        {
-            delayMS += 100.0;
-            printf("delayMS: %.4f\n", delayMS);
-            fflush(stdout);
 
-            break;
-        }
-        case 'd':
-        {
-            delayMS -= 100.0;
-            printf("delayMS: %.4f\n", delayMS);
-            fflush(stdout);
-            break;
-        }
-        case 'r':
-        {
-            feedback += 1.0;
-            printf("feedback: %.4f\n", feedback);
-            fflush(stdout);
-            break;
-        }
-        case 'f':
-        {
-            feedback -= 1.0;
-            printf("feedback: %.4f\n", feedback);
-            fflush(stdout);
-            break;
-        }
-        case 't':
-        {
-            wet += 1.0;
-            printf("wet: %.4f\n", wet);
-            fflush(stdout);
-            break;
-        }
-        case 'g':
-        {
-            wet -= 1.0;
-            printf("wet: %.4f\n", wet);
-            fflush(stdout);
-            break;
+                channels[numChannels++] = bufferToFill.buffer->getWritePointer(channel, bufferToFill.startSample);
+            }
         }
     }
 
-    // eq param
-    switch(serialData)
-    {
-        case 'x':
-        {
-            lowVol += 0.5;
-            printf("lowVol: %.4f\n", lowVol);
-            fflush(stdout);
-            break;
-        }
-        case 'z':
-        {
-            lowVol -= 0.5;
-            printf("lowVol: %.4f\n", lowVol);
-            fflush(stdout);
-            break;
-        }
-        case 'm':
-        {
-            highVol += 0.5;
-            printf("highVol: %.4f\n", highVol);
-            fflush(stdout);
-            break;
-        }
-        case 'n':
-        {
-            highVol -= 0.5;
-            printf("highVol: %.4f\n", highVol);
-            fflush(stdout);
-            break;
-        }
-        case '1':
-        {
-            lowFreq = 100; 
-            printf("lowFreq: %.4f\n", lowFreq);
-            fflush(stdout);
-            break;
-        }
-        case '2':
-        {
-            lowFreq = 200; 
-            printf("lowFreq: %.4f\n", lowFreq);
-            fflush(stdout);
-            break;
-        }
-        case '3':
-        {
-            lowFreq = 300; 
-            printf("lowFreq: %.4f\n", lowFreq);
-            fflush(stdout);
-            break;
-        }
-        case '4':
-        {
-            lowFreq = 400; 
-            printf("lowFreq: %.4f\n", lowFreq);
-            fflush(stdout);
-            break;
-        }
-        case '7':
-        {
-            highFreq = 700; 
-            printf("highFreq: %.4f\n", highFreq);
-            fflush(stdout);
-            break;
-        }
-        case '8':
-        {
-            highFreq = 800; 
-            printf("highFreq: %.4f\n", highFreq);
-            fflush(stdout);
-            break;
-        }
-        case '9':
-        {
-            highFreq = 900; 
-            printf("highFreq: %.4f\n", highFreq);
-            fflush(stdout);
-            break;
-        }
-        case '0':
-        {
-            highFreq = 1000; 
-            printf("highFreq: %.4f\n", highFreq);
-            fflush(stdout);
-            break;
-        }
-        case '-':
-        {
-            highFreq = 2000; 
-            printf("highFreq: %.4f\n", highFreq);
-            fflush(stdout);
-            break;
-        }
-        case '=':
-        {
-            highFreq = 3000; 
-            printf("highFreq: %.4f\n", highFreq);
-            fflush(stdout);
-            break;
-        }
-    }
+    fxChain.process(channels, numChannels, bufferToFill.numSamples);
 }
 
 void MainComponent::releaseResources()
@@ -531,7 +171,10 @@ void MainComponent::resized()
     auto topLine(rect.removeFromTop(20));
     cpuUsageLabel.setBounds(topLine.removeFromLeft(topLine.getWidth() / 2));
     cpuUsageText.setBounds(topLine);
-    rect.removeFromTop(20);
+    rect.removeFromTop(10);
+
+    timingsBox.setBounds(rect.removeFromTop(130));
+    rect.removeFromTop(10);
 
     diagnosticsBox.setBounds(rect);
 }
@@ -559,8 +202,69 @@ String MainComponent::getListOfActiveBits(const BigInteger& b)
 
 void MainComponent::timerCallback()
 {
+    Trace::setThreadName("message");
+    TraceScope scope("gui timer");
+
     auto cpu = deviceManager.getCpuUsage() * 100;
     cpuUsageText.setText(String(cpu, 6) + " %", dontSendNotification);
+
+    // the timer runs at 20 Hz, the table only needs to change about once a second
+    if(++timerTicks % 20 == 0)
+    {
+        showTimings();
+    }
+}
+
+void MainComponent::showTimings()
+{
+    auto text = String(fxChain.getTimings().format());
+
+    // what the driver saw, including anything outside the chain; -1 where it doesn't count them
+    if(auto* device = deviceManager.getCurrentAudioDevice())
+    {
+        text << "device xruns " << device->getXRunCount();
+    }
+
+    if(RealtimeCheck::compiledIn)
+    {
+        text << "\nreal-time violations " << static_cast<int>(RealtimeCheck::getViolations());
+    }
+
+    timingsBox.setText(text, false);
+}
+
+void MainComponent::footswitchesChanged(uint32 switchMask)
+{
+    // bit n switches FXStage n
+    auto description = fxChain.getDescription();
+    for(int stage = 0; stage < NUM_STAGES; ++stage)
+    {
+        description.enabled[stage] = (switchMask >> stage) & 1;
+    }
+
+    // stamped a block ahead, so every switch lands with the same latency instead of at whatever block boundary comes first
+    fxChain.setDescription(description, fxChain.getEventTime());
+}
+
+void MainComponent::parameterChanged(FXParameterID id, float value)
+{
+    // the EQ's knobs go as one stamped design once the batch is in, see parametersChanged()
+    if(FXParameters::getInfo(id).stage == FXStage::EQ)
+    {
+        return;
+    }
+
+    // likewise sample accurate, unless the queue is full (no audio running) and it waits for the next block
+    if(!fxChain.scheduleParameter(id, value, fxChain.getEventTime()))
+    {
+        parameters.markDirty(id);
+    }
+}
+
+void MainComponent::parametersChanged(const FXParameters& newParameters)
+{
+    // designed here on the serial thread, and switched to at its sample like the other knobs
+    fxChain.setEQParameters(newParameters, fxChain.getEventTime());
 }
 
 void MainComponent::dumpDeviceInfo()
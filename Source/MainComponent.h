@@ -2,25 +2,10 @@
 
 #include "../JuceLibraryCode/JuceHeader.h"
 
-// wiringPi stuff
-#if defined(JUCE_LINUX) && defined(__arm__)
-#define RASPBERRY_PI 1
-extern "C" {
-#include <wiringPi.h>
-#include <wiringSerial.h>
-#include <mcp23008.h>
-}
-#endif
-
 // user includes
-#include "DSP/DelayLine.h"
-#include "DSP/BiQuad.h"
-
-// switch gpio mapped to wiringPi
-#define SWITCH1 3 // OD
-#define SWITCH2 4 // Dist
-#define SWITCH3 5 // EQ
-#define SWITCH4 6 // Delay
+#include "DSP/FXChain.h"
+#include "Control/SerialControl.h"
+#include "Control/FootswitchService.h"
 
 //static constexpr float PI = 3.14159265 defined in biquad class
 
@@ -28,6 +13,8 @@ class MainComponent
     : public AudioAppComponent
     , public ChangeListener
     , private Timer
+    , private FootswitchService::Listener
+    , private SerialControl::Listener
 {
 public:
     MainComponent();
@@ -40,15 +27,14 @@ public:
     void paint (Graphics& g) override;
     void resized() override;
 
-    float overdrive(float sample, float blend, float vol);
-    float distortion(float sample, float drive, float blend, float tone, float vol);
-
 private:
-    void updateFXParam();
-
     void changeListenerCallback(ChangeBroadcaster*) override;
     static String getListOfActiveBits(const BigInteger& b);
     void timerCallback() override;
+    void showTimings();
+    void footswitchesChanged(uint32 switchMask) override;
+    void parameterChanged(FXParameterID id, float value) override;
+    void parametersChanged(const FXParameters& newParameters) override;
     void dumpDeviceInfo();
     void logMessage(const String& m);
 
@@ -56,40 +42,24 @@ private:
     AudioDeviceSelectorComponent audioSetupComp; // for allowing choice of device
 
     // DSP stuff
-    DelayLine delayLine;
-    BiQuad lowBand, highBand; // low pass and high pass filter for EQ
-
-    // effect parameters
-    // eventually effects will be their own class this is just for a quick prototype
-    // actually these parameters may actually need to be here... 
-
-    // distortion/overdrive
-    float odBlend;
-    float odVol;
-    float distDrive;
-    float distBlend;
-    float distTone;
-    float distVol;
+    FXChain fxChain;
 
-    // delay
-    float delayMS;
-    float feedback;
-    float wet;
+    // effect parameters, set from the serial thread and stamped into the chain as they change
+    ParameterRegistry parameters;
 
-    // eq
-    float lowVol;
-    float highVol;
-    float lowFreq;
-    float highFreq;
+    // footswitches, polled and debounced off the audio thread
+    FootswitchService footswitches;
 
     // serial stuff
-    int serialPort;
-    char serialData;
+    ConsoleLogger logger;
+    SerialControl serialControl;
 
     // diagnostic information
     Label cpuUsageLabel;
     Label cpuUsageText;
+    TextEditor timingsBox;
     TextEditor diagnosticsBox;
+    int timerTicks = 0;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainComponent)
 };
@@ -0,0 +1,46 @@
+#include "BiQuadLanes.h"
+
+void BiQuadLanes::setCoefficients(const BiQuad<float>& design)
+{
+	const auto& coefficients = design.getCoefficients();
+
+	filter.setCoefficients({
+		Float4::splat(coefficients.b0),
+		Float4::splat(coefficients.b1),
+		Float4::splat(coefficients.b2),
+		Float4::splat(coefficients.a1),
+		Float4::splat(coefficients.a2)
+	});
+}
+
+void BiQuadLanes::reset()
+{
+	filter.reset();
+}
+
+void BiQuadLanes::process(float* frames, int numFrames, int numChannels)
+{
+	switch(numChannels)
+	{
+		case 1: processFrames<1>(frames, numFrames); break;
+		case 2: processFrames<2>(frames, numFrames); break;
+		case 4: processFrames<4>(frames, numFrames); break;
+	}
+}
+
+template <int NumChannels>
+void BiQuadLanes::processFrames(float* frames, int numFrames)
+{
+	// a local copy so the state stays in registers for the whole block
+	BiQuad<Float4> local = filter;
+
+	for(int i = 0; i < numFrames; ++i)
+	{
+		float* frame = frames + i * NumChannels;
+
+		// spare lanes of a narrower frame just filter zeros
+		local.process(Float4::loadFirst(frame, NumChannels)).storeFirst(frame, NumChannels);
+	}
+
+	filter = local;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../../../Source/DSP/BiQuad.h"
+#include "../../../Source/DSP/SIMD.h"
+
+/*
+ * A benchmark-only comparison, not part of the pedal: one BiQuad run over up
+ * to four interleaved channels at once, each channel's state in its own Float4
+ * lane. The recursion is a chain of dependent multiply-adds either way, so two
+ * or four channels cost about what one does. It's BiQuad<Float4> underneath;
+ * this only deals with the frame layout.
+ */
+class BiQuadLanes
+{
+public:
+	// takes the coefficients the design filter currently has, the state is left alone
+	void setCoefficients(const BiQuad<float>& design);
+	void reset();
+
+	// numFrames frames of numChannels (1, 2 or 4) interleaved samples, in place
+	void process(float* frames, int numFrames, int numChannels);
+
+private:
+	template <int NumChannels>
+	void processFrames(float* frames, int numFrames);
+
+	// coefficients splatted across the lanes, one channel per lane
+	BiQuad<Float4> filter;
+};
@@ -0,0 +1,602 @@
+/*
+ * Benchmarks
+ *
+ * Times the DSP building blocks one at a time across block sizes, sample rates
+ * and parameter settings. Every result is reported as ns/sample and as the
+ * fraction of the real-time budget for one block (blockSize / sampleRate) the
+ * stage eats, so a number above 1.0 means that stage alone would xrun.
+ *
+ * usage: Benchmarks [--json results.json] [--filter stage] [--quick]
+ *
+ * The JSON file carries the cpu and build info so results from two builds or
+ * two machines can be diffed.
+ */
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "BiQuadLanes.h"
+#include "../../../Source/DSP/FXChain.h"
+#include "../../../Source/DSP/ModulatedDelay.h"
+#include "../../../Source/DSP/MultiTapDelay.h"
+#include "../../../Source/DSP/Oversampler.h"
+#include "../../../Source/DSP/ParametricEQ.h"
+#include "../../../Source/DSP/Waveshaper.h"
+#include "../../../Source/DSP/WaveshaperTable.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+struct BenchmarkResult
+{
+    String stage;
+    String setting;
+    double sampleRate;
+    int blockSize;
+    double nsPerBlock;
+    double nsPerSample;
+    double budgetFraction;
+};
+
+// one call processes one block of blockSize samples in place
+using BlockFunction = std::function<void(float*, int)>;
+
+class BenchmarkRunner
+{
+public:
+    BenchmarkRunner(bool quickMode, const String& stageFilter)
+    : quick(quickMode)
+    , filter(stageFilter)
+    {
+        Random random(0x5eed);
+
+        // a second of noise is plenty, blocks are read from it round robin
+        input.resize(96000);
+        for(auto& sample : input)
+        {
+            sample = random.nextFloat() * 2.0f - 1.0f;
+        }
+    }
+
+    bool wants(const String& stage) const
+    {
+        return filter.isEmpty() || stage.containsIgnoreCase(filter);
+    }
+
+    void run(const String& stage, const String& setting, double sampleRate, int blockSize, const BlockFunction& function)
+    {
+        if(!wants(stage))
+        {
+            return;
+        }
+
+        std::vector<float> block(static_cast<size_t>(blockSize));
+
+        // enough blocks per measurement to swamp the timer, then take the median of several
+        const int samplesPerRun = quick ? (1 << 14) : (1 << 17);
+        const int blocksPerRun = jmax(1, samplesPerRun / blockSize);
+        const int numRuns = quick ? 3 : 9;
+
+        size_t readPosition = 0;
+        auto nextBlock = [&]()
+        {
+            if(readPosition + block.size() > input.size())
+            {
+                readPosition = 0;
+            }
+            std::copy(input.begin() + readPosition, input.begin() + readPosition + block.size(), block.begin());
+            readPosition += block.size();
+        };
+
+        // warm up caches and branch predictors
+        for(int i = 0; i < blocksPerRun; ++i)
+        {
+            nextBlock();
+            function(block.data(), blockSize);
+        }
+
+        std::vector<double> runNs;
+        for(int run = 0; run < numRuns; ++run)
+        {
+            int64 ticks = 0;
+            for(int i = 0; i < blocksPerRun; ++i)
+            {
+                nextBlock();
+
+                auto start = Time::getHighResolutionTicks();
+                function(block.data(), blockSize);
+                ticks += Time::getHighResolutionTicks() - start;
+
+                checksum += block[0];
+            }
+            runNs.push_back(Time::highResolutionTicksToSeconds(ticks) * 1.0e9 / blocksPerRun);
+        }
+
+        std::sort(runNs.begin(), runNs.end());
+
+        BenchmarkResult result;
+        result.stage = stage;
+        result.setting = setting;
+        result.sampleRate = sampleRate;
+        result.blockSize = blockSize;
+        result.nsPerBlock = runNs[runNs.size() / 2];
+        result.nsPerSample = result.nsPerBlock / blockSize;
+        result.budgetFraction = result.nsPerBlock / (blockSize / sampleRate * 1.0e9);
+
+        printf("%-28s %-22s %7.0f Hz %5d  %10.2f ns/sample  %8.4f of budget\n",
+            stage.toRawUTF8(),
+            setting.toRawUTF8(),
+            sampleRate,
+            blockSize,
+            result.nsPerSample,
+            result.budgetFraction);
+        fflush(stdout);
+
+        results.push_back(result);
+    }
+
+    var toJSON() const
+    {
+        auto* root = new DynamicObject();
+
+        auto* build = new DynamicObject();
+        build->setProperty("cpu", SystemStats::getCpuModel());
+        build->setProperty("cpuVendor", SystemStats::getCpuVendor());
+        build->setProperty("numCpus", SystemStats::getNumCpus());
+        build->setProperty("os", SystemStats::getOperatingSystemName());
+        build->setProperty("juce", SystemStats::getJUCEVersion());
+        build->setProperty("compiled", String(__DATE__) + " " + __TIME__);
+       #if JUCE_DEBUG
+        build->setProperty("config", "Debug");
+       #else
+        build->setProperty("config", "Release");
+       #endif
+        root->setProperty("build", var(build));
+
+        Array<var> list;
+        for(auto& r : results)
+        {
+            auto* entry = new DynamicObject();
+            entry->setProperty("stage", r.stage);
+            entry->setProperty("setting", r.setting);
+            entry->setProperty("sampleRate", r.sampleRate);
+            entry->setProperty("blockSize", r.blockSize);
+            entry->setProperty("nsPerBlock", r.nsPerBlock);
+            entry->setProperty("nsPerSample", r.nsPerSample);
+            entry->setProperty("budgetFraction", r.budgetFraction);
+            list.add(var(entry));
+        }
+        root->setProperty("results", list);
+
+        return var(root);
+    }
+
+    float getChecksum() const
+    {
+        return checksum;
+    }
+
+private:
+    bool quick;
+    String filter;
+
+    std::vector<float> input;
+    std::vector<BenchmarkResult> results;
+
+    // keeps the optimiser from throwing the work away
+    float checksum = 0;
+};
+
+//==============================================================================
+static const char* filterTypeName(FilterType type)
+{
+    switch(type)
+    {
+        case FilterType::PEAK:      return "peak";
+        case FilterType::LOW_PASS:  return "lowpass";
+        case FilterType::HIGH_PASS: return "highpass";
+        case FilterType::LOW_SHELF: return "lowshelf";
+        case FilterType::HIGH_SHELF: return "highshelf";
+    }
+    return "?";
+}
+
+static void benchmarkBiQuad(BenchmarkRunner& runner, double fs, int blockSize)
+{
+    const FilterType types[] = { FilterType::PEAK, FilterType::LOW_PASS, FilterType::HIGH_PASS, FilterType::LOW_SHELF, FilterType::HIGH_SHELF };
+
+    for(auto type : types)
+    {
+        BiQuad<float> filter(type);
+        filter.calculateCoefficients(static_cast<float>(fs), 400.0f, 6.0f);
+
+        runner.run("BiQuad::process(block)", filterTypeName(type), fs, blockSize, [&](float* buffer, int numSamples)
+        {
+            filter.process(buffer, numSamples);
+        });
+
+        filter.reset();
+        runner.run("BiQuad::process(sample)", filterTypeName(type), fs, blockSize, [&](float* buffer, int numSamples)
+        {
+            for(int i = 0; i < numSamples; ++i)
+            {
+                buffer[i] = filter.process(buffer[i]);
+            }
+        });
+
+        // stereo and four channels in lanes, the block is the first channel and the rest is filler
+        for(int numChannels : { 2, 4 })
+        {
+            BiQuadLanes lanes;
+            lanes.setCoefficients(filter);
+
+            std::vector<float> frames(static_cast<size_t>(blockSize * numChannels));
+            auto setting = String(filterTypeName(type)) + ", " + String(numChannels) + " ch";
+
+            runner.run("BiQuadLanes::process", setting, fs, blockSize, [&](float* buffer, int numSamples)
+            {
+                for(int i = 0; i < numSamples; ++i)
+                {
+                    frames[static_cast<size_t>(i * numChannels)] = buffer[i];
+                }
+
+                lanes.process(frames.data(), numSamples, numChannels);
+                buffer[0] = frames[0];
+            });
+        }
+
+        // the same design run in double, for where float's rounding shows (shelves and passes far below fs)
+        BiQuad<double> precise(type);
+        precise.calculateCoefficients(fs, 400.0, 6.0);
+
+        std::vector<double> wide(static_cast<size_t>(blockSize));
+        runner.run("BiQuad<double>::process(block)", filterTypeName(type), fs, blockSize, [&](float* buffer, int numSamples)
+        {
+            std::copy(buffer, buffer + numSamples, wide.begin());
+            precise.process(wide.data(), numSamples);
+            std::transform(wide.begin(), wide.begin() + numSamples, buffer, [](double x) { return static_cast<float>(x); });
+        });
+
+        // happens once per block whenever a knob moves, so the block budget is what matters
+        float f0 = 100.0f;
+        runner.run("BiQuad::calculateCoefficients", filterTypeName(type), fs, blockSize, [&](float* buffer, int)
+        {
+            f0 = f0 > 3000.0f ? 100.0f : f0 + 1.0f;
+            filter.calculateCoefficients(static_cast<float>(fs), f0, buffer[0]);
+        });
+    }
+}
+
+// what the old EQ cost (two full BiQuad passes) against the cascade with 2 to 10 bands
+static void benchmarkParametricEQ(BenchmarkRunner& runner, double fs, int blockSize)
+{
+    BiQuad<float> low(FilterType::PEAK), high(FilterType::PEAK);
+    low.calculateCoefficients(static_cast<float>(fs), 100.0f, 6.0f);
+    high.calculateCoefficients(static_cast<float>(fs), 1000.0f, -3.0f);
+
+    runner.run("ParametricEQ::process", "2 BiQuad passes", fs, blockSize, [&](float* buffer, int numSamples)
+    {
+        low.process(buffer, numSamples);
+        high.process(buffer, numSamples);
+    });
+
+    // a typical mix layout: cut below, shelves, peaks in between, roll off above
+    EQBand bands[ParametricEQ::maxBands];
+    bands[0].type = FilterType::HIGH_PASS;
+    bands[0].frequency = 40.0f;
+    bands[0].slope = 24;
+    bands[1].type = FilterType::LOW_PASS;
+    bands[1].frequency = 12000.0f;
+    bands[1].slope = 24;
+    bands[2].type = FilterType::LOW_SHELF;
+    bands[2].frequency = 120.0f;
+    bands[2].gain = 3.0f;
+    bands[3].type = FilterType::HIGH_SHELF;
+    bands[3].frequency = 6000.0f;
+    bands[3].gain = -2.0f;
+
+    for(int band = 4; band < ParametricEQ::maxBands; ++band)
+    {
+        bands[band].frequency = 200.0f * (band - 3);
+        bands[band].gain = band % 2 == 0 ? 4.0f : -4.0f;
+        bands[band].Q = 1.5f;
+    }
+
+    for(int numBands : { 2, 6, 8, ParametricEQ::maxBands })
+    {
+        ParametricEQ equaliser;
+        equaliser.prepare(static_cast<float>(fs), 1);
+        equaliser.setBands(bands, numBands);
+
+        auto setting = String(numBands) + " bands, " + String(equaliser.getNumSections()) + " sections";
+
+        runner.run("ParametricEQ::process", setting, fs, blockSize, [&](float* buffer, int numSamples)
+        {
+            equaliser.process(buffer, numSamples);
+        });
+
+        // the last band moving every block: the design plus a block that ramps to it
+        auto& moving = bands[numBands - 1];
+        const float startF0 = moving.frequency;
+
+        runner.run("ParametricEQ::process(sweeping)", setting, fs, blockSize, [&](float* buffer, int numSamples)
+        {
+            moving.frequency = moving.frequency > 3000.0f ? 200.0f : moving.frequency + 10.0f;
+            equaliser.setBands(bands, numBands);
+            equaliser.process(buffer, numSamples);
+        });
+
+        moving.frequency = startF0;
+    }
+}
+
+static void benchmarkDelayLine(BenchmarkRunner& runner, double fs, int blockSize)
+{
+    const float delayTimes[] = { 0.0f, 300.0f, 1500.0f };
+
+    for(auto delayMs : delayTimes)
+    {
+        DelayLine delay;
+        delay.updateParameters(delayMs, 40.0f, 50.0f, static_cast<float>(fs));
+        delay.prepareBuffer(static_cast<float>(fs));
+
+        auto setting = String(delayMs, 0) + " ms";
+
+        runner.run("DelayLine::process", setting, fs, blockSize, [&](float* buffer, int numSamples)
+        {
+            delay.process(buffer, numSamples);
+        });
+
+        runner.run("DelayLine::cookVariables", setting, fs, blockSize, [&](float*, int)
+        {
+            delay.cookVariables(static_cast<float>(fs));
+        });
+    }
+}
+
+static void benchmarkMultiTapDelay(BenchmarkRunner& runner, double fs, int blockSize)
+{
+    for(int numTaps : { 1, 4, MultiTapDelay::maxTaps })
+    {
+        MultiTapDelay delay;
+        delay.prepare(static_cast<float>(fs));
+        delay.setNumTaps(numTaps);
+
+        // spread over the whole line, eighths of 1500 ms
+        for(int t = 0; t < numTaps; ++t)
+        {
+            MultiTapDelay::Tap tap;
+            tap.delayMs = 1500.0f * (t + 1) / MultiTapDelay::maxTaps;
+            tap.gain = 0.5f;
+            tap.pan = t % 2 == 0 ? -0.5f : 0.5f;
+            tap.feedback = 0.3f / numTaps;
+            delay.setTap(t, tap);
+        }
+
+        std::vector<float> left(static_cast<size_t>(blockSize)), right(static_cast<size_t>(blockSize));
+        auto setting = String(numTaps) + (numTaps == 1 ? " tap" : " taps");
+
+        runner.run("MultiTapDelay::process", setting, fs, blockSize, [&](float* buffer, int numSamples)
+        {
+            delay.process(buffer, left.data(), right.data(), numSamples);
+            buffer[0] = left[0] + right[0];
+        });
+    }
+}
+
+static void benchmarkModulatedDelay(BenchmarkRunner& runner, double fs, int blockSize)
+{
+    struct Preset { const char* name; ModulatedDelay::Settings settings; };
+    const Preset presets[] = {
+        { "chorus", ModulatedDelay::Settings::chorus() },
+        { "flanger", ModulatedDelay::Settings::flanger() }
+    };
+
+    const ReadInterpolation interpolations[] = {
+        ReadInterpolation::TWO_POINT_LINEAR,
+        ReadInterpolation::FOUR_POINT_HERMITE,
+        ReadInterpolation::FOUR_POINT_LAGRANGE
+    };
+    const char* interpolationNames[] = { "linear", "hermite", "lagrange" };
+
+    for(auto& preset : presets)
+    {
+        for(int i = 0; i < 3; ++i)
+        {
+            ModulatedDelay delay;
+            delay.prepare(static_cast<float>(fs));
+            delay.setSettings(preset.settings);
+            delay.setInterpolation(interpolations[i]);
+
+            runner.run("ModulatedDelay::process", String(preset.name) + ", " + interpolationNames[i], fs, blockSize, [&](float* buffer, int numSamples)
+            {
+                delay.process(buffer, numSamples);
+            });
+        }
+    }
+}
+
+static void benchmarkWaveshapers(BenchmarkRunner& runner, double fs, int blockSize)
+{
+    FXChain chain;
+    static WaveshaperTable table;
+
+    struct Setting { const char* name; float drive, blend, tone, vol; };
+    const Setting settings[] = {
+        { "default", 0.5f, 0.5f, 900.0f, 1.0f },
+        { "full blend, hot", 1.0f, 1.0f, 2000.0f, 1.0f }
+    };
+
+    for(auto& s : settings)
+    {
+        runner.run("FXChain::overdrive", s.name, fs, blockSize, [&](float* buffer, int numSamples)
+        {
+            for(int i = 0; i < numSamples; ++i)
+            {
+                buffer[i] = chain.overdrive(buffer[i], s.blend, s.vol);
+            }
+        });
+
+        runner.run("FXChain::distortion", s.name, fs, blockSize, [&](float* buffer, int numSamples)
+        {
+            for(int i = 0; i < numSamples; ++i)
+            {
+                buffer[i] = chain.distortion(buffer[i], s.drive, s.blend, s.tone, s.vol);
+            }
+        });
+
+        runner.run("overdriveBlock", s.name, fs, blockSize, [&](float* buffer, int numSamples)
+        {
+            overdriveBlock(buffer, numSamples, s.blend, s.vol);
+        });
+
+        runner.run("distortionBlock", s.name, fs, blockSize, [&](float* buffer, int numSamples)
+        {
+            distortionBlock(buffer, numSamples, s.drive, s.blend, s.tone, s.vol);
+        });
+
+        // a knob mid ramp, what the smoothed gains cost on top of the fixed ones
+        const ParameterRamp blendRamp = { 0.5f * s.blend, s.blend };
+        const ParameterRamp volRamp = { 0.5f * s.vol, s.vol };
+        const ParameterRamp gainRamp = { s.drive * s.tone, s.drive * s.tone };
+
+        runner.run("overdriveBlock, ramping", s.name, fs, blockSize, [&](float* buffer, int numSamples)
+        {
+            overdriveBlock(buffer, numSamples, blendRamp, volRamp, 1);
+        });
+
+        runner.run("distortionBlock, ramping", s.name, fs, blockSize, [&](float* buffer, int numSamples)
+        {
+            distortionBlock(buffer, numSamples, gainRamp, blendRamp, volRamp, 1);
+        });
+
+        // the tables cost the same whatever the curve, one of each interpolation is enough
+        for(auto interpolation : { TableInterpolation::LINEAR, TableInterpolation::CUBIC })
+        {
+            table.build(ShaperCurve::TUBE, 0.5f, interpolation);
+
+            auto name = String(s.name) + (interpolation == TableInterpolation::LINEAR ? ", linear" : ", cubic");
+            runner.run("WaveshaperTable::process", name, fs, blockSize, [&](float* buffer, int numSamples)
+            {
+                table.process(buffer, numSamples, s.drive * s.tone, s.blend, s.vol);
+            });
+        }
+
+        // the filters cost the same whatever the kernel, distortionBlock is the heavier of the two
+        for(int factor = 2; factor <= Oversampler::maxFactor; factor *= 2)
+        {
+            Oversampler oversampler;
+            oversampler.prepare(blockSize);
+            oversampler.setFactor(factor);
+
+            auto name = String(s.name) + ", " + String(factor) + "x";
+            runner.run("Oversampler+distortionBlock", name, fs, blockSize, [&](float* buffer, int numSamples)
+            {
+                oversampler.process(buffer, numSamples, [&](float* block, int blockLength)
+                {
+                    distortionBlock(block, blockLength, s.drive, s.blend, s.tone, s.vol);
+                });
+            });
+        }
+    }
+}
+
+// the per-block cost of the bank: all settled (the usual case), one knob turning, and everything moving at once
+static void benchmarkSmoothedParameters(BenchmarkRunner& runner, double fs, int blockSize)
+{
+    for(int moving : { 0, 1, SmoothedParameters::maxParameters })
+    {
+        SmoothedParameters smoothed;
+        smoothed.prepare(static_cast<float>(fs), 20.0f);
+
+        float value = 0.0f;
+        runner.run("SmoothedParameters::advance", String(moving) + " moving", fs, blockSize, [&](float* buffer, int numSamples)
+        {
+            // a new target every block keeps them from ever settling
+            value = value > 1.0f ? 0.0f : value + 0.01f;
+            for(int index = 0; index < moving; ++index)
+            {
+                smoothed.setTarget(index, value);
+            }
+
+            smoothed.advance(numSamples);
+            buffer[0] += smoothed.getRamp(0).end;
+        });
+    }
+}
+
+// the whole chain the way the pedal runs it; the effects see the same sub-blocks whatever blockSize is
+static void benchmarkFXChain(BenchmarkRunner& runner, double fs, int blockSize)
+{
+    FXParameters parameters;
+    parameters.delayMS = 300.0f;
+    parameters.feedback = 40.0f;
+    parameters.wet = 50.0f;
+    parameters.lowVol = 3.0f;
+    parameters.highVol = -3.0f;
+
+    for(int factor : { 1, 4 })
+    {
+        FXChain chain;
+        chain.setParameters(parameters);
+        chain.setEQParameters(parameters);
+        chain.setOversampling(factor);
+
+        for(int stage = 0; stage < NUM_STAGES; ++stage)
+        {
+            chain.setStageEnabled(static_cast<FXStage>(stage), true);
+        }
+
+        chain.prepare(static_cast<float>(fs), blockSize);
+
+        runner.run("FXChain::process", "every stage, " + String(factor) + "x oversampling", fs, blockSize, [&](float* buffer, int numSamples)
+        {
+            chain.process(buffer, numSamples);
+        });
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    ArgumentList args(argc, argv);
+
+    const bool quick = args.containsOption("--quick");
+    BenchmarkRunner runner(quick, args.getValueForOption("--filter"));
+
+    const double sampleRates[] = { 44100.0, 48000.0, 96000.0 };
+
+    for(auto fs : sampleRates)
+    {
+        for(int blockSize = 16; blockSize <= 4096; blockSize *= 2)
+        {
+            benchmarkBiQuad(runner, fs, blockSize);
+            benchmarkParametricEQ(runner, fs, blockSize);
+            benchmarkDelayLine(runner, fs, blockSize);
+            benchmarkMultiTapDelay(runner, fs, blockSize);
+            benchmarkModulatedDelay(runner, fs, blockSize);
+            benchmarkWaveshapers(runner, fs, blockSize);
+            benchmarkSmoothedParameters(runner, fs, blockSize);
+            benchmarkFXChain(runner, fs, blockSize);
+        }
+
+        if(quick)
+        {
+            break;
+        }
+    }
+
+    printf("checksum %g\n", runner.getChecksum());
+
+    if(args.containsOption("--json"))
+    {
+        File out = File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--json"));
+        if(!out.replaceWithText(JSON::toString(runner.toJSON())))
+        {
+            fprintf(stderr, "can't write %s\n", out.getFullPathName().toRawUTF8());
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,384 @@
+/*
+ * ControlTests
+ *
+ * Checks the serial control protocol (Source/Control/ControlProtocol.h) the
+ * way the pedal meets it on the wire: frames round trip through the encoder
+ * and parser, the parser finds its way back after frames that were damaged,
+ * keys are only taken from a board that sends keys, and line noise doesn't
+ * make up frames. Prints every check and exits non-zero if any failed.
+ *
+ * usage: ControlTests [--seed n]
+ *
+ * Everything random comes from the seed (1 unless given), so a failure can
+ * be run again as it was.
+ */
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../../../Source/Control/ControlProtocol.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <stdio.h>
+#include <vector>
+
+using Bytes = std::vector<uint8_t>;
+using Frame = std::vector<ControlEntry>;
+
+static int numFailed = 0;
+
+static void check(bool passed, const char* what)
+{
+    printf("%s %s\n", passed ? "ok    " : "FAILED", what);
+
+    if(!passed)
+    {
+        ++numFailed;
+    }
+}
+
+// bit for bit, so NaNs and -0 count too
+static bool sameEntries(const Frame& a, const Frame& b)
+{
+    if(a.size() != b.size())
+    {
+        return false;
+    }
+
+    for(size_t i = 0; i < a.size(); ++i)
+    {
+        if(a[i].id != b[i].id || std::memcmp(&a[i].value, &b[i].value, sizeof(float)) != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// any number of entries, any ids, any float bits, so every byte value turns up in the payload (the sync byte too)
+static Frame randomFrame(std::mt19937& random)
+{
+    Frame frame(std::uniform_int_distribution<int>(1, ControlProtocol::maxEntries)(random));
+
+    for(auto& entry : frame)
+    {
+        const uint32_t bits = random();
+        entry.id = static_cast<uint8_t>(random());
+        std::memcpy(&entry.value, &bits, sizeof(float));
+    }
+
+    return frame;
+}
+
+static Bytes encode(const Frame& frame)
+{
+    ControlFrameEncoder encoder;
+    for(const auto& entry : frame)
+    {
+        encoder.add(entry.id, entry.value);
+    }
+
+    const uint8_t* data = encoder.getData();
+    return Bytes(data, data + encoder.getSize());
+}
+
+// what the parser made of some bytes
+struct Parsed
+{
+    std::vector<Frame> frames;
+    int keys = 0;
+    int badFrames = 0;
+    int noise = 0;
+};
+
+static void feed(ControlFrameParser& parser, const Bytes& bytes, Parsed& parsed)
+{
+    for(auto byte : bytes)
+    {
+        switch(parser.feed(byte))
+        {
+            case ControlFrameParser::Result::FRAME:
+                parsed.frames.emplace_back(parser.getEntries(), parser.getEntries() + parser.getNumEntries());
+                break;
+
+            case ControlFrameParser::Result::OUTSIDE_FRAME: ++parsed.keys; break;
+            case ControlFrameParser::Result::BAD_FRAME:     ++parsed.badFrames; break;
+            case ControlFrameParser::Result::NOISE:         ++parsed.noise; break;
+            case ControlFrameParser::Result::PENDING:       break;
+        }
+    }
+}
+
+static Bytes keys(const char* text)
+{
+    return Bytes(text, text + std::strlen(text));
+}
+
+//==============================================================================
+static void testCrc()
+{
+    const auto data = keys("123456789");
+    check(ControlProtocol::crc(data.data(), static_cast<int>(data.size())) == 0x29b1, "crc: CRC-16/CCITT-FALSE check value");
+}
+
+static void testEncoder()
+{
+    ControlFrameEncoder encoder;
+    check(encoder.getSize() == 0, "encoder: nothing to send while empty");
+
+    int added = 0;
+    while(encoder.add(0, 0.0f))
+    {
+        ++added;
+    }
+
+    check(added == ControlProtocol::maxEntries && encoder.getSize() == ControlProtocol::maxFrameSize, "encoder: full at maxEntries");
+
+    encoder.clear();
+    check(encoder.getNumEntries() == 0 && encoder.getSize() == 0, "encoder: clear() empties it");
+}
+
+static void testRoundTrip(std::mt19937& random)
+{
+    ControlFrameParser parser;
+    bool allPending = true;
+    bool allEqual = true;
+
+    for(int i = 0; i < 10000; ++i)
+    {
+        const Frame sent = randomFrame(random);
+        const Bytes bytes = encode(sent);
+
+        for(size_t b = 0; b + 1 < bytes.size(); ++b)
+        {
+            allPending &= parser.feed(bytes[b]) == ControlFrameParser::Result::PENDING;
+        }
+
+        allEqual &= parser.feed(bytes.back()) == ControlFrameParser::Result::FRAME
+                    && sameEntries(sent, Frame(parser.getEntries(), parser.getEntries() + parser.getNumEntries()));
+    }
+
+    check(allPending, "round trip: every byte but the last of a frame is pending");
+    check(allEqual, "round trip: 10000 random frames decode bit for bit");
+}
+
+static void testKeys(std::mt19937& random)
+{
+    ControlFrameParser parser;
+    Parsed parsed;
+
+    feed(parser, keys("qa1"), parsed);
+    check(parsed.keys == 3, "keys: taken while no frame has come");
+
+    feed(parser, encode(randomFrame(random)), parsed);
+    feed(parser, keys("qa1"), parsed);
+    check(parsed.frames.size() == 1 && parsed.keys == 3 && parsed.noise == 3, "keys: not taken once a good frame has come");
+
+    parser.lineIdle();
+    feed(parser, keys("q"), parsed);
+    check(parsed.keys == 3, "keys: not taken after an idle line either");
+
+    parser.reset();
+    feed(parser, keys("q"), parsed);
+    check(parsed.keys == 4, "keys: taken again after reset()");
+}
+
+// payload after a sync byte is never keys, even before the first good frame
+static void testFailedFramesDontLeak(std::mt19937& random)
+{
+    {
+        ControlFrameParser parser;
+        Parsed parsed;
+
+        feed(parser, { ControlProtocol::syncByte, 0, 'q', 'w', 'e' }, parsed);
+        check(parsed.badFrames == 1 && parsed.keys == 0 && parsed.noise == 3, "leaks: bytes after a bad count aren't keys");
+
+        check(!parser.lineIdle(), "leaks: no frame was half way in");
+        feed(parser, keys("q"), parsed);
+        check(parsed.keys == 1, "leaks: keys again after an idle line");
+    }
+
+    {
+        ControlFrameParser parser;
+        Parsed parsed;
+
+        Bytes bytes = encode(randomFrame(random));
+        bytes.back() ^= 0x01;
+        bytes.push_back('q');
+
+        feed(parser, bytes, parsed);
+        check(parsed.badFrames == 1 && parsed.keys == 0 && parsed.noise == 1, "leaks: bytes after a bad crc aren't keys");
+    }
+
+    {
+        ControlFrameParser parser;
+        Parsed parsed;
+
+        // the sync byte lost, which leaves the payload looking like anything
+        Bytes bytes = encode(randomFrame(random));
+        feed(parser, bytes, parsed);
+        bytes.erase(bytes.begin());
+        feed(parser, bytes, parsed);
+        check(parsed.frames.size() == 1 && parsed.keys == 0, "leaks: a frame without its sync byte isn't keys");
+    }
+}
+
+/*
+ * A burst of frames with one of them damaged on the wire: a byte flipped,
+ * dropped or added, or its sync byte lost. Every frame before it has to come
+ * through and the parser has to be back in sync within a few frames. Each
+ * frame it tries while hunting that wasn't sent gets past the 16 bit crc one
+ * time in 65536, so made up frames are only held to about that.
+ */
+static void testResync(std::mt19937& random)
+{
+    static constexpr int framesPerBurst = 20;
+    static constexpr int damaged = 5;
+    static constexpr int resyncedBy = damaged + 6;
+
+    const char* const damages[] = { "flipped byte", "dropped byte", "added byte", "lost sync byte" };
+
+    for(int damage = 0; damage < 4; ++damage)
+    {
+        bool before = true;
+        bool after = true;
+        bool noKeys = true;
+        int worst = 0;
+        int madeUp = 0;
+        int tried = 0;
+
+        for(int trial = 0; trial < 2000; ++trial)
+        {
+            std::vector<Frame> sent;
+            Bytes bytes;
+
+            for(int i = 0; i < framesPerBurst; ++i)
+            {
+                sent.push_back(randomFrame(random));
+                Bytes frame = encode(sent.back());
+
+                if(i == damaged)
+                {
+                    const size_t at = std::uniform_int_distribution<size_t>(1, frame.size() - 1)(random);
+
+                    switch(damage)
+                    {
+                        case 0: frame[at] ^= static_cast<uint8_t>(1 << (random() % 8)); break;
+                        case 1: frame.erase(frame.begin() + static_cast<long>(at)); break;
+                        case 2: frame.insert(frame.begin() + static_cast<long>(at), static_cast<uint8_t>(random())); break;
+                        case 3: frame.erase(frame.begin()); break;
+                    }
+                }
+
+                bytes.insert(bytes.end(), frame.begin(), frame.end());
+            }
+
+            ControlFrameParser parser;
+            Parsed parsed;
+            feed(parser, bytes, parsed);
+
+            // matched up in order, each decoded frame to the next sent one it equals
+            int next = 0;
+            int firstAfter = framesPerBurst;
+
+            for(const auto& frame : parsed.frames)
+            {
+                int match = next;
+                while(match < framesPerBurst && !sameEntries(frame, sent[static_cast<size_t>(match)]))
+                {
+                    ++match;
+                }
+
+                if(match == framesPerBurst)
+                {
+                    ++madeUp;
+                    continue;
+                }
+
+                before &= match == next || match > damaged;
+
+                if(match > damaged)
+                {
+                    firstAfter = std::min(firstAfter, match);
+                }
+
+                next = match + 1;
+            }
+
+            before &= next >= damaged;
+            after &= firstAfter <= resyncedBy && next == framesPerBurst;
+            noKeys &= parsed.keys == 0;
+            worst = std::max(worst, firstAfter);
+            tried += parsed.badFrames;
+        }
+
+        tried += madeUp;
+        printf("       %s: the first frame back was at most number %d after it; %d made up of %d tried\n", damages[damage], worst - damaged, madeUp, tried);
+
+        const String what = String("resync, ") + damages[damage] + ": ";
+        check(before, (what + "the frames before it all come through").toRawUTF8());
+        check(after, (what + "back in sync within " + String(resyncedBy - damaged) + " frames, and stays").toRawUTF8());
+        check(madeUp <= 1 + tried / 16384, (what + "no more made up frames than the crc lets through").toRawUTF8());
+        check(noKeys, (what + "none of it taken as keys").toRawUTF8());
+    }
+}
+
+// the board pauses between bursts, which drops whatever half frame the damage left behind
+static void testIdleLine(std::mt19937& random)
+{
+    ControlFrameParser parser;
+    Parsed parsed;
+
+    Bytes cut = encode(randomFrame(random));
+    cut.resize(cut.size() / 2);
+    feed(parser, cut, parsed);
+
+    check(parser.lineIdle(), "idle line: the half frame is dropped");
+
+    const Frame sent = randomFrame(random);
+    feed(parser, encode(sent), parsed);
+    check(parsed.frames.size() == 1 && sameEntries(parsed.frames[0], sent), "idle line: the next frame comes through whole");
+}
+
+static void testNoise(std::mt19937& random)
+{
+    Bytes bytes(2000000);
+    for(auto& byte : bytes)
+    {
+        byte = static_cast<uint8_t>(random());
+    }
+
+    ControlFrameParser parser;
+    Parsed parsed;
+    feed(parser, bytes, parsed);
+
+    const auto firstSync = std::find(bytes.begin(), bytes.end(), ControlProtocol::syncByte) - bytes.begin();
+
+    printf("       2M random bytes: %d bad frames, %d noise\n", parsed.badFrames, parsed.noise);
+    check(parsed.frames.empty(), "noise: 2M random bytes make no frames");
+    check(parsed.keys == firstSync, "noise: nothing after the first sync byte taken as keys");
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    ArgumentList args(argc, argv);
+
+    const auto seed = static_cast<std::mt19937::result_type>(args.containsOption("--seed") ? args.getValueForOption("--seed").getLargeIntValue() : 1);
+    std::mt19937 random(seed);
+
+    printf("seed %u\n", static_cast<unsigned>(seed));
+
+    testCrc();
+    testEncoder();
+    testRoundTrip(random);
+    testKeys(random);
+    testFailedFramesDontLeak(random);
+    testResync(random);
+    testIdleLine(random);
+    testNoise(random);
+
+    printf("%d failed\n", numFailed);
+    return numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,423 @@
+/*
+ * DSPTests
+ *
+ * Checks what the stages in Source/DSP do to a signal: impulses and sines go
+ * in, and the output has to have the echoes, levels, pans and delays the
+ * settings ask for, on their own and through FXChain the way the pedal runs
+ * them. Prints every check and exits non-zero if any failed.
+ *
+ * usage: DSPTests
+ */
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../../../Source/DSP/DelayLine.h"
+#include "../../../Source/DSP/FXChain.h"
+#include "../../../Source/DSP/ModulatedDelay.h"
+#include "../../../Source/DSP/MultiTapDelay.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdio.h>
+#include <vector>
+
+using Signal = std::vector<float>;
+
+static constexpr float sampleRate = 48000.0f;
+
+static int numFailed = 0;
+
+static void check(bool passed, const char* what)
+{
+    printf("%s %s\n", passed ? "ok    " : "FAILED", what);
+
+    if(!passed)
+    {
+        ++numFailed;
+    }
+}
+
+static Signal impulse(int length)
+{
+    Signal signal(static_cast<size_t>(length), 0.0f);
+    signal[0] = 1.0f;
+    return signal;
+}
+
+static int msToSamples(float ms)
+{
+    return static_cast<int>(ms * sampleRate / 1000.0f);
+}
+
+// what's left of a response once the expected echoes are taken out of it
+struct Echo
+{
+    int time;
+    float level;
+};
+
+static bool onlyEchoes(Signal response, const std::vector<Echo>& echoes, float tolerance = 1.0e-6f)
+{
+    for(const auto& echo : echoes)
+    {
+        if(std::abs(response[static_cast<size_t>(echo.time)] - echo.level) > tolerance)
+        {
+            return false;
+        }
+
+        response[static_cast<size_t>(echo.time)] = 0.0f;
+    }
+
+    for(auto sample : response)
+    {
+        if(std::abs(sample) > tolerance)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static Signal sine(int length, float frequency, float delaySamples = 0.0f)
+{
+    Signal signal(static_cast<size_t>(length));
+    for(size_t i = 0; i < signal.size(); ++i)
+    {
+        signal[i] = static_cast<float>(std::sin(2.0 * 3.14159265358979 * frequency * (static_cast<double>(i) - delaySamples) / sampleRate));
+    }
+
+    return signal;
+}
+
+static float largestDifference(const Signal& a, const Signal& b, size_t from)
+{
+    float largest = 0.0f;
+    for(size_t i = from; i < a.size(); ++i)
+    {
+        largest = std::max(largest, std::abs(a[i] - b[i]));
+    }
+
+    return largest;
+}
+
+static float peak(const Signal& signal, size_t from, size_t to)
+{
+    float largest = 0.0f;
+    for(size_t i = from; i < to; ++i)
+    {
+        largest = std::max(largest, std::abs(signal[i]));
+    }
+
+    return largest;
+}
+
+//==============================================================================
+// a left, a centre and a right tap, none of them fed back
+static const MultiTapDelay::Tap panTaps[] =
+{
+    { 10.0f, 0.5f, -1.0f, 0.0f },
+    { 25.0f, 0.25f, 0.0f, 0.0f },
+    { 37.5f, 0.8f, 1.0f, 0.0f }
+};
+
+static const float centre = std::sqrt(0.5f);
+
+static void setTaps(MultiTapDelay& delay, const MultiTapDelay::Tap* taps, int numTaps)
+{
+    for(int t = 0; t < numTaps; ++t)
+    {
+        delay.setTap(t, taps[t]);
+    }
+
+    delay.setNumTaps(numTaps);
+}
+
+static void testMultiTapImpulse()
+{
+    MultiTapDelay delay;
+    delay.prepare(sampleRate);
+    delay.setDryLevel(0.0f);
+    setTaps(delay, panTaps, 3);
+
+    const Signal input = impulse(4096);
+    Signal left(input.size());
+    Signal right(input.size());
+    delay.process(input.data(), left.data(), right.data(), static_cast<int>(input.size()));
+
+    const int first = msToSamples(10.0f);
+    const int second = msToSamples(25.0f);
+    const int third = msToSamples(37.5f);
+
+    check(onlyEchoes(left, { { first, 0.5f }, { second, 0.25f * centre }, { third, 0.0f } }), "multi tap: left has each tap at its time, at its gain and pan");
+    check(onlyEchoes(right, { { first, 0.0f }, { second, 0.25f * centre }, { third, 0.8f } }), "multi tap: right has each tap at its time, at its gain and pan");
+
+    delay.reset();
+    delay.setDryLevel(1.0f);
+
+    Signal mono = input;
+    delay.process(mono.data(), static_cast<int>(mono.size()));
+    check(onlyEchoes(mono, { { 0, 1.0f }, { first, 0.5f }, { second, 0.25f }, { third, 0.8f } }), "multi tap: mono has the dry input and every tap at its gain, pan ignored");
+}
+
+static void testMultiTapFeedback()
+{
+    MultiTapDelay delay;
+    delay.prepare(sampleRate);
+    delay.setDryLevel(0.0f);
+
+    const MultiTapDelay::Tap tap = { 10.0f, 0.5f, 0.0f, 0.5f };
+    setTaps(delay, &tap, 1);
+
+    Signal response = impulse(4096);
+    delay.process(response.data(), static_cast<int>(response.size()));
+
+    const int time = msToSamples(10.0f);
+    check(onlyEchoes(response, { { time, 0.5f }, { 2 * time, 0.25f }, { 3 * time, 0.125f }, { 4 * time, 0.0625f }, { 5 * time, 0.03125f },
+                                 { 6 * time, 0.015625f }, { 7 * time, 0.0078125f }, { 8 * time, 0.00390625f } }),
+          "multi tap: each repeat is the last one times the feedback");
+}
+
+// sends adding up to far more than 1 would build up without end if they were taken as they are
+static void testMultiTapFeedbackLimit()
+{
+    MultiTapDelay delay;
+    delay.prepare(sampleRate);
+
+    const MultiTapDelay::Tap taps[] =
+    {
+        { 10.0f, 0.5f, 0.0f, 0.9f },
+        { 13.0f, 0.5f, 0.0f, 0.9f },
+        { 17.0f, 0.5f, 0.0f, -0.9f }
+    };
+
+    setTaps(delay, taps, 3);
+    check(delay.getTap(2).feedback == -0.9f, "multi tap: getTap() has the send as it was set");
+
+    // ten seconds of white-ish noise in, then silence
+    Signal signal(static_cast<size_t>(sampleRate) * 20);
+    uint32_t noise = 1;
+    for(size_t i = 0; i < signal.size() / 2; ++i)
+    {
+        noise = noise * 1664525u + 1013904223u;
+        signal[i] = static_cast<float>(noise >> 8) / 8388608.0f - 1.0f;
+    }
+
+    delay.process(signal.data(), static_cast<int>(signal.size()));
+
+    const size_t second = static_cast<size_t>(sampleRate);
+    const float loudest = peak(signal, 0, signal.size());
+    const float last = peak(signal, signal.size() - second, signal.size());
+
+    printf("       sends adding up to 2.7: peak %.1f, %.2g in the last second\n", loudest, last);
+    check(std::isfinite(loudest) && loudest < 200.0f, "multi tap: sends adding up to more than 1 don't run away");
+    check(last < 0.1f * peak(signal, signal.size() / 2, signal.size() / 2 + second), "multi tap: and die away once the input stops");
+}
+
+//==============================================================================
+static const char* const interpolationNames[] = { "linear", "hermite", "lagrange" };
+
+// with nothing to sweep it is a plain fractional delay, so the same settings have to sound like DelayLine
+static void testModulatedMatchesDelayLine()
+{
+    const float delays[] = { 2.5f, 7.3177083f };
+    const Signal input = sine(8192, 441.0f);
+
+    for(auto delayMs : delays)
+    {
+        DelayLine line;
+        line.updateParameters(delayMs, 40.0f, 35.0f, sampleRate);
+        line.prepareBuffer(sampleRate);
+
+        Signal expected = input;
+        line.process(expected.data(), static_cast<int>(expected.size()));
+
+        // on a whole sample every interpolation is the sample itself, between two only the linear one is DelayLine's
+        const bool wholeSamples = delayMs * sampleRate / 1000.0f == std::floor(delayMs * sampleRate / 1000.0f);
+
+        for(int interpolation = 0; interpolation < 3; ++interpolation)
+        {
+            if(!wholeSamples && interpolation != ReadInterpolation::TWO_POINT_LINEAR)
+            {
+                continue;
+            }
+
+            ModulatedDelay::Settings settings;
+            settings.delayMs = delayMs;
+            settings.depthMs = 0.0f;
+            settings.feedback = 0.4f;
+            settings.wet = 0.35f;
+            settings.dry = 0.65f;
+
+            ModulatedDelay delay;
+            delay.prepare(sampleRate);
+            delay.setSettings(settings);
+            delay.setInterpolation(static_cast<ReadInterpolation>(interpolation));
+
+            Signal output = input;
+            delay.process(output.data(), static_cast<int>(output.size()));
+
+            const String what = "modulated: no depth matches DelayLine at " + String(delayMs * sampleRate / 1000.0f) + " samples, " + interpolationNames[interpolation];
+            check(largestDifference(output, expected, 0) < 1.0e-5f, what.toRawUTF8());
+        }
+    }
+}
+
+// a sine read back between samples, against the sine the fractional delay should give
+static void testModulatedFractionalSine()
+{
+    const float delaySamples = 100.37f;
+    const float frequencies[] = { 1000.0f, 4000.0f };
+
+    // worst case error allowed per interpolation, at each frequency
+    const float tolerances[][2] = { { 5.0e-3f, 5.0e-2f }, { 1.0e-4f, 5.0e-3f }, { 5.0e-5f, 4.0e-3f } };
+    float errors[3][2];
+
+    for(int f = 0; f < 2; ++f)
+    {
+        const Signal input = sine(8192, frequencies[f]);
+
+        ModulatedDelay::Settings settings;
+        settings.delayMs = delaySamples * 1000.0f / sampleRate;
+        settings.depthMs = 0.0f;
+        settings.feedback = 0.0f;
+        settings.wet = 1.0f;
+        settings.dry = 0.0f;
+
+        // the delay the line really runs at, after the round trip through milliseconds
+        const Signal expected = sine(8192, frequencies[f], settings.delayMs * (sampleRate / 1000.0f));
+
+        for(int interpolation = 0; interpolation < 3; ++interpolation)
+        {
+            ModulatedDelay delay;
+            delay.prepare(sampleRate);
+            delay.setSettings(settings);
+            delay.setInterpolation(static_cast<ReadInterpolation>(interpolation));
+
+            Signal output = input;
+            delay.process(output.data(), static_cast<int>(output.size()));
+
+            errors[interpolation][f] = largestDifference(output, expected, 256);
+        }
+    }
+
+    for(int interpolation = 0; interpolation < 3; ++interpolation)
+    {
+        printf("       %s: %.2g at 1 kHz, %.2g at 4 kHz\n", interpolationNames[interpolation], errors[interpolation][0], errors[interpolation][1]);
+
+        const String what = String("modulated: ") + interpolationNames[interpolation] + " reproduces a sine 100.37 samples late";
+        check(errors[interpolation][0] < tolerances[interpolation][0] && errors[interpolation][1] < tolerances[interpolation][1], what.toRawUTF8());
+    }
+
+    check(errors[1][0] < errors[0][0] && errors[2][0] < errors[0][0], "modulated: the four point reads beat the linear one");
+}
+
+static void testModulatedFeedbackLimit()
+{
+    ModulatedDelay::Settings settings = ModulatedDelay::Settings::flanger();
+    settings.feedback = -1.5f;
+
+    ModulatedDelay delay;
+    delay.prepare(sampleRate);
+    delay.setSettings(settings);
+
+    Signal response = impulse(static_cast<int>(sampleRate) * 10);
+    delay.process(response.data(), static_cast<int>(response.size()));
+
+    const size_t second = static_cast<size_t>(sampleRate);
+    check(peak(response, response.size() - second, response.size()) < 1.0e-3f, "modulated: feedback past 1 is held below it and dies away");
+}
+
+//==============================================================================
+// the delay stage on its own through the chain, the other three switched off
+static void prepareDelayChain(FXChain& chain, const DelayVoicing& voicing, int numChannels)
+{
+    FXParameters parameters;
+    chain.setParameters(parameters);
+    chain.setEQParameters(parameters);
+    chain.setDelayVoicing(voicing);
+
+    for(int stage = 0; stage < NUM_STAGES; ++stage)
+    {
+        chain.setStageEnabled(static_cast<FXStage>(stage), stage == FXStage::DELAY);
+    }
+
+    chain.prepare(sampleRate, 256, numChannels);
+}
+
+static void testChainMultiTap()
+{
+    DelayVoicing voicing;
+    voicing.mode = DelayMode::MULTI_TAP;
+    voicing.numTaps = 3;
+    std::copy(panTaps, panTaps + 3, voicing.taps);
+
+    FXChain chain;
+    prepareDelayChain(chain, voicing, 2);
+
+    Signal left = impulse(4096);
+    Signal right = impulse(4096);
+    float* channels[] = { left.data(), right.data() };
+    chain.process(channels, 2, static_cast<int>(left.size()));
+
+    const int first = msToSamples(10.0f);
+    const int second = msToSamples(25.0f);
+    const int third = msToSamples(37.5f);
+
+    check(onlyEchoes(left, { { 0, 1.0f }, { first, 0.5f }, { second, 0.25f * centre }, { third, 0.0f } }), "chain multi tap: left is the input and the taps panned left");
+    check(onlyEchoes(right, { { 0, 1.0f }, { first, 0.0f }, { second, 0.25f * centre }, { third, 0.8f } }), "chain multi tap: right is the input and the taps panned right");
+}
+
+// every channel through its own line, at the same settings, so identical channels stay identical
+static void testChainModulated()
+{
+    DelayVoicing voicing;
+    voicing.mode = DelayMode::MODULATED;
+    voicing.modulation = ModulatedDelay::Settings::chorus();
+    voicing.interpolation = ReadInterpolation::FOUR_POINT_LAGRANGE;
+
+    const Signal input = sine(8192, 441.0f);
+
+    ModulatedDelay delay;
+    delay.prepare(sampleRate);
+    delay.setSettings(voicing.modulation);
+    delay.setInterpolation(voicing.interpolation);
+
+    // in the chain's sub-blocks, the LFO is worked out a run at a time
+    Signal expected = input;
+    for(int i = 0; i < static_cast<int>(expected.size()); i += FXChain::subBlockSize)
+    {
+        delay.process(expected.data() + i, FXChain::subBlockSize);
+    }
+
+    FXChain chain;
+    prepareDelayChain(chain, voicing, 4);
+
+    Signal outputs[4] = { input, input, input, input };
+    float* channels[] = { outputs[0].data(), outputs[1].data(), outputs[2].data(), outputs[3].data() };
+    chain.process(channels, 4, static_cast<int>(input.size()));
+
+    bool same = true;
+    for(const auto& output : outputs)
+    {
+        same &= largestDifference(output, expected, 0) == 0.0f;
+    }
+
+    check(same, "chain modulated: four channels each run the chorus as ModulatedDelay does");
+}
+
+//==============================================================================
+int main (int, char*[])
+{
+    testMultiTapImpulse();
+    testMultiTapFeedback();
+    testMultiTapFeedbackLimit();
+    testModulatedMatchesDelayLine();
+    testModulatedFractionalSine();
+    testModulatedFeedbackLimit();
+    testChainMultiTap();
+    testChainModulated();
+
+    printf("%d failed\n", numFailed);
+    return numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,722 @@
+/*
+ * OfflineRender
+ *
+ * Runs recorded audio through the same FXChain the pedal uses, with no GPIO,
+ * serial port or audio device involved. Settings come from a JSON file:
+ *
+ *  {
+ *      "parameters": { "odBlend": 0.5, "distDrive": 0.75, "delayMS": 300, ... },
+ *      "switches":   { "overdrive": true, "distortion": false, "eq": true, "delay": true },
+ *      "driveCurve": { "curve": "tube", "shape": 0.5, "interpolation": "cubic" },
+ *      "oversampling": 4,
+ *      "delayVoicing": { "mode": "multitap", "taps": [ { "delayMs": 375, "gain": 0.5, "pan": -1, "feedback": 0.3 },
+ *                                                    { "delayMs": 500, "gain": 0.4, "pan": 1 } ] },
+ *      "eqBands":    [ { "type": "highpass", "frequency": 80, "slope": 24 },
+ *                      { "type": "highshelf", "frequency": 5000, "gain": -3, "q": 0.7 } ],
+ *      "automation": [ { "time": 1.5, "parameter": "odVol", "value": 0.25 },
+ *                      { "time": 2.0, "switch": "delay", "on": false } ]
+ *  }
+ *
+ * Parameter names are the FXParameters members, anything left out keeps its default.
+ * driveCurve is optional: classic, tube, fuzz or asymmetric; interpolation linear or cubic.
+ * oversampling is optional: 1, 2, 4 or 8 for the overdrive and distortion stages.
+ * delayVoicing is optional: echo (the delay knobs, the default), multitap, or chorus,
+ * flanger or vibrato. multitap takes up to MultiTapDelay::maxTaps taps with pan -1 (left)
+ * to 1 (right); their feedback sends are scaled down together if they add up to more
+ * than 0.98. chorus, flanger and vibrato start from ModulatedDelay's presets, any of
+ * delayMs, depthMs, rateHz, feedback, wet and dry given replaces the preset's, and
+ * interpolation is linear, hermite (the default) or lagrange:
+ *      "delayVoicing": { "mode": "flanger", "rateHz": 0.1, "interpolation": "lagrange" }
+ * eqBands is optional, extra EQ bands after the lowVol/highVol peaks: peak, lowshelf,
+ * highshelf, lowpass or highpass; slope (12, 24, 36 or 48) is for the passes only.
+ * automation is optional, changes that land on the sample at time (in seconds) through
+ * the chain's event queue, whatever the block size: a parameter to a value, or a switch
+ * (named like in switches) on or off.
+ *
+ * usage: OfflineRender [--settings file.json] [--block-size n] [--jobs n] [--stats] [--trace file.json] input output
+ *
+ * --stats times every stage of the chain and prints p50/p99/max per block after each file.
+ * --trace writes a Chrome trace (chrome://tracing, ui.perfetto.dev) of every block and stage
+ * on every worker. Flat out, the chain records events faster than they can be written, so a
+ * long render's trace has gaps, marked as dropped events; trace a few seconds of audio instead.
+ *
+ * The Debug build checks the chain is real-time safe (see RealtimeCheck.h): anything it does
+ * that the audio callback mustn't is reported with a backtrace and fails the render.
+ *
+ * input/output can be a pair of files or a pair of directories, in which case
+ * every .wav/.aif/.aiff in the input directory is rendered on a pool of worker threads.
+ */
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../../../Source/DSP/FXChain.h"
+#include "../../../Source/DSP/RealtimeCheck.h"
+#include "../../../Source/DSP/Trace.h"
+
+#include <stdio.h>
+
+struct AutomationPoint
+{
+    double time = 0;
+    bool isSwitch = false;
+    FXParameterID parameter = FXParameterID::OD_BLEND;
+    FXStage stage = FXStage::OVERDRIVE;
+    float value = 0; // 1 or 0 for a switch
+};
+
+// sorts by time, keeping the order of the file for points at the same time
+struct AutomationOrder
+{
+    static int compareElements(const AutomationPoint& a, const AutomationPoint& b)
+    {
+        return a.time < b.time ? -1 : (b.time < a.time ? 1 : 0);
+    }
+};
+
+struct RenderSettings
+{
+    FXParameters parameters;
+    bool stageEnabled[NUM_STAGES] = { false, false, false, false };
+    ShaperCurve driveCurve = ShaperCurve::CLASSIC;
+    float driveShape = 0.5f;
+    TableInterpolation driveInterpolation = TableInterpolation::CUBIC;
+    int oversampling = 1;
+    DelayVoicing delayVoicing;
+    Array<EQBand> eqBands;
+    Array<AutomationPoint> automation;
+    int blockSize = 4096;
+    bool stats = false;
+};
+
+struct RenderResult
+{
+    File input;
+    bool ok = false;
+    String error;
+    int64 numSamples = 0;
+    int numChannels = 0;
+    double sampleRate = 0;
+    double processSeconds = 0;
+    double totalSeconds = 0;
+    String timings;
+};
+
+//==============================================================================
+static bool loadSettings(const File& file, RenderSettings& settings, String& error)
+{
+    var json;
+    auto result = JSON::parse(file.loadFileAsString(), json);
+
+    if(result.failed())
+    {
+        error = file.getFullPathName() + ": " + result.getErrorMessage();
+        return false;
+    }
+
+    auto params = json["parameters"];
+    for(int id = 0; id < NUM_PARAMETERS; ++id)
+    {
+        auto parameter = static_cast<FXParameterID>(id);
+        auto name = FXParameters::getName(parameter);
+
+        if(params.hasProperty(name))
+        {
+            settings.parameters.set(parameter, static_cast<float>(params[name]));
+        }
+    }
+
+    auto switches = json["switches"];
+    settings.stageEnabled[FXStage::OVERDRIVE] = switches["overdrive"];
+    settings.stageEnabled[FXStage::DISTORTION] = switches["distortion"];
+    settings.stageEnabled[FXStage::EQ] = switches["eq"];
+    settings.stageEnabled[FXStage::DELAY] = switches["delay"];
+
+    auto drive = json["driveCurve"];
+    if(drive.isObject())
+    {
+        const StringArray curveNames { "classic", "tube", "fuzz", "asymmetric" };
+        auto curve = curveNames.indexOf(drive["curve"].toString().toLowerCase());
+
+        if(curve < 0)
+        {
+            error = "unknown driveCurve " + drive["curve"].toString().quoted();
+            return false;
+        }
+
+        settings.driveCurve = static_cast<ShaperCurve>(curve);
+        settings.driveShape = drive.hasProperty("shape") ? static_cast<float>(drive["shape"]) : 0.5f;
+        settings.driveInterpolation = drive["interpolation"].toString() == "linear"
+            ? TableInterpolation::LINEAR
+            : TableInterpolation::CUBIC;
+    }
+
+    if(json.hasProperty("oversampling"))
+    {
+        settings.oversampling = json["oversampling"];
+    }
+
+    auto voicing = json["delayVoicing"];
+    if(voicing.isObject())
+    {
+        const StringArray modeNames { "echo", "multitap", "chorus", "flanger", "vibrato" };
+        auto mode = modeNames.indexOf(voicing["mode"].toString().toLowerCase());
+
+        if(mode < 0)
+        {
+            error = "unknown delayVoicing mode " + voicing["mode"].toString().quoted();
+            return false;
+        }
+
+        settings.delayVoicing.mode = static_cast<DelayMode>(jmin(mode, static_cast<int>(DelayMode::MODULATED)));
+
+        if(settings.delayVoicing.mode == DelayMode::MODULATED)
+        {
+            auto& modulation = settings.delayVoicing.modulation;
+            modulation = mode == 2 ? ModulatedDelay::Settings::chorus()
+                       : mode == 3 ? ModulatedDelay::Settings::flanger()
+                       : ModulatedDelay::Settings::vibrato();
+
+            modulation.delayMs = voicing.hasProperty("delayMs") ? static_cast<float>(voicing["delayMs"]) : modulation.delayMs;
+            modulation.depthMs = voicing.hasProperty("depthMs") ? static_cast<float>(voicing["depthMs"]) : modulation.depthMs;
+            modulation.rateHz = voicing.hasProperty("rateHz") ? static_cast<float>(voicing["rateHz"]) : modulation.rateHz;
+            modulation.feedback = voicing.hasProperty("feedback") ? static_cast<float>(voicing["feedback"]) : modulation.feedback;
+            modulation.wet = voicing.hasProperty("wet") ? static_cast<float>(voicing["wet"]) : modulation.wet;
+            modulation.dry = voicing.hasProperty("dry") ? static_cast<float>(voicing["dry"]) : modulation.dry;
+
+            // same order as ReadInterpolation
+            const StringArray interpolationNames { "linear", "hermite", "lagrange" };
+            auto interpolation = voicing.hasProperty("interpolation") ? interpolationNames.indexOf(voicing["interpolation"].toString().toLowerCase()) : 1;
+
+            if(interpolation < 0)
+            {
+                error = "unknown delayVoicing interpolation " + voicing["interpolation"].toString().quoted();
+                return false;
+            }
+
+            settings.delayVoicing.interpolation = static_cast<ReadInterpolation>(interpolation);
+        }
+
+        if(auto* taps = voicing["taps"].getArray())
+        {
+            if(taps->size() > MultiTapDelay::maxTaps)
+            {
+                error = "delayVoicing takes at most " + String(MultiTapDelay::maxTaps) + " taps";
+                return false;
+            }
+
+            for(auto& entry : *taps)
+            {
+                auto& tap = settings.delayVoicing.taps[settings.delayVoicing.numTaps++];
+                tap.delayMs = static_cast<float>(entry["delayMs"]);
+                tap.gain = static_cast<float>(entry["gain"]);
+                tap.pan = static_cast<float>(entry["pan"]);
+                tap.feedback = static_cast<float>(entry["feedback"]);
+            }
+        }
+    }
+
+    if(auto* bands = json["eqBands"].getArray())
+    {
+        // same order as FilterType
+        const StringArray typeNames { "peak", "lowpass", "highpass", "lowshelf", "highshelf" };
+
+        for(auto& entry : *bands)
+        {
+            auto type = typeNames.indexOf(entry["type"].toString().toLowerCase());
+
+            if(type < 0)
+            {
+                error = "unknown eqBands type " + entry["type"].toString().quoted();
+                return false;
+            }
+
+            EQBand band;
+            band.type = static_cast<FilterType>(type);
+            band.frequency = static_cast<float>(entry["frequency"]);
+            band.gain = static_cast<float>(entry["gain"]);
+            band.Q = entry.hasProperty("q") ? static_cast<float>(entry["q"]) : band.Q;
+            band.slope = entry.hasProperty("slope") ? static_cast<int>(entry["slope"]) : band.slope;
+            settings.eqBands.add(band);
+        }
+
+        if(settings.eqBands.size() > ParametricEQ::maxBands - 2)
+        {
+            error = "eqBands takes at most " + String(ParametricEQ::maxBands - 2) + " bands";
+            return false;
+        }
+    }
+
+    if(auto* points = json["automation"].getArray())
+    {
+        // same order as FXStage
+        const StringArray stageNames { "overdrive", "distortion", "eq", "delay" };
+
+        for(auto& entry : *points)
+        {
+            AutomationPoint point;
+            point.time = jmax(0.0, static_cast<double>(entry["time"]));
+
+            if(entry.hasProperty("switch"))
+            {
+                auto stage = stageNames.indexOf(entry["switch"].toString().toLowerCase());
+
+                if(stage < 0)
+                {
+                    error = "unknown automation switch " + entry["switch"].toString().quoted();
+                    return false;
+                }
+
+                point.isSwitch = true;
+                point.stage = static_cast<FXStage>(stage);
+                point.value = static_cast<bool>(entry["on"]) ? 1.0f : 0.0f;
+            }
+            else
+            {
+                auto name = entry["parameter"].toString();
+                auto id = 0;
+
+                while(id < NUM_PARAMETERS && name != FXParameters::getName(static_cast<FXParameterID>(id)))
+                {
+                    ++id;
+                }
+
+                if(id == NUM_PARAMETERS)
+                {
+                    error = "can't automate parameter " + name.quoted();
+                    return false;
+                }
+
+                point.parameter = static_cast<FXParameterID>(id);
+                point.value = static_cast<float>(entry["value"]);
+            }
+
+            settings.automation.add(point);
+        }
+
+        AutomationOrder order;
+        settings.automation.sort(order, true);
+    }
+
+    return true;
+}
+
+//==============================================================================
+static RenderResult renderFile(const File& input, const File& output, const RenderSettings& settings)
+{
+    RenderResult result;
+    result.input = input;
+
+    auto startTicks = Time::getHighResolutionTicks();
+
+    AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<AudioFormatReader> reader(formatManager.createReaderFor(input));
+    if(reader == nullptr)
+    {
+        result.error = "can't read " + input.getFullPathName();
+        return result;
+    }
+
+    auto* format = formatManager.findFormatForFileExtension(output.getFileExtension());
+    if(format == nullptr)
+    {
+        result.error = "unknown output format " + output.getFileName();
+        return result;
+    }
+
+    output.deleteFile();
+    std::unique_ptr<FileOutputStream> stream(output.createOutputStream());
+    if(stream == nullptr)
+    {
+        result.error = "can't write " + output.getFullPathName();
+        return result;
+    }
+
+    auto numChannels = static_cast<int>(reader->numChannels);
+    auto bitDepth = static_cast<int>(reader->bitsPerSample);
+    std::unique_ptr<AudioFormatWriter> writer(format->createWriterFor(
+        stream.get(),
+        reader->sampleRate,
+        reader->numChannels,
+        bitDepth > 0 && bitDepth <= 32 ? bitDepth : 24,
+        {},
+        0
+    ));
+
+    if(writer == nullptr)
+    {
+        result.error = "can't create writer for " + output.getFullPathName();
+        return result;
+    }
+    stream.release(); // writer owns the stream now
+
+    // the channels go through the chain up to FXChain::maxChannels at a time, like the pedal runs them
+    OwnedArray<FXChain> chains;
+    for(int first = 0; first < numChannels; first += FXChain::maxChannels)
+    {
+        auto* chain = chains.add(new FXChain());
+        chain->setParameters(settings.parameters);
+        chain->setEQParameters(settings.parameters);
+        chain->setDriveCurve(settings.driveCurve, settings.driveShape, settings.driveInterpolation);
+        chain->setDelayVoicing(settings.delayVoicing);
+        chain->setOversampling(settings.oversampling);
+        chain->setTimingEnabled(settings.stats);
+
+        if(!chain->setEQBands(settings.eqBands.begin(), settings.eqBands.size()))
+        {
+            result.error = "eqBands need more than " + String(ParametricEQ::maxSections) + " filter sections";
+            return result;
+        }
+
+        // switches first, so prepare starts the stages fully in rather than fading them up
+        for(int stage = 0; stage < NUM_STAGES; ++stage)
+        {
+            chain->setStageEnabled(static_cast<FXStage>(stage), settings.stageEnabled[stage]);
+        }
+
+        chain->prepare(static_cast<float>(reader->sampleRate), settings.blockSize, jmin(FXChain::maxChannels, numChannels - first));
+    }
+
+    AudioBuffer<float> buffer(numChannels, settings.blockSize);
+    int64 processTicks = 0;
+
+    // the chains' timelines count from 0 like position does, so the points are stamped with where they land in the file
+    int nextPoint = 0;
+
+    // the EQ's knobs as automated so far, each change to them is a whole new design
+    auto eqParameters = settings.parameters;
+
+    for(int64 position = 0; position < reader->lengthInSamples;)
+    {
+        auto end = jmin<int64>(position + settings.blockSize, reader->lengthInSamples);
+
+        // a block ends early at a second switch or EQ time, as a chain only keeps the newest layout change
+        // and EQ design waiting, or at a parameter that didn't fit in the queue
+        int64 switchTime = -1;
+        int64 eqTime = -1;
+
+        for(; nextPoint < settings.automation.size(); ++nextPoint)
+        {
+            const auto& point = settings.automation.getReference(nextPoint);
+            auto time = jmax(position, static_cast<int64>(std::llround(point.time * reader->sampleRate)));
+
+            if(time >= end)
+            {
+                break;
+            }
+
+            if(point.isSwitch)
+            {
+                if(switchTime >= 0 && time != switchTime)
+                {
+                    end = time;
+                    break;
+                }
+
+                switchTime = time;
+                for(auto* chain : chains)
+                {
+                    chain->setStageEnabled(point.stage, point.value > 0.0f, time);
+                }
+                continue;
+            }
+
+            if(FXParameters::getInfo(point.parameter).stage == FXStage::EQ)
+            {
+                if(eqTime >= 0 && time != eqTime)
+                {
+                    end = time;
+                    break;
+                }
+
+                eqTime = time;
+                eqParameters.set(point.parameter, point.value);
+
+                for(auto* chain : chains)
+                {
+                    chain->setEQParameters(eqParameters, time);
+                }
+                continue;
+            }
+
+            // the chains' queues fill up in step, so either all of them take it or none does
+            auto queued = true;
+            for(auto* chain : chains)
+            {
+                queued = chain->scheduleParameter(point.parameter, point.value, time) && queued;
+            }
+
+            if(!queued)
+            {
+                end = jmax(position + 1, time);
+                break;
+            }
+        }
+
+        auto numSamples = static_cast<int>(end - position);
+
+        Trace::begin("read");
+        reader->read(&buffer, 0, numSamples, position, true, true);
+        Trace::end("read");
+
+        auto blockStart = Time::getHighResolutionTicks();
+        {
+            // what the pedal runs in its audio callback
+            RealtimeScope realtime;
+
+            for(int i = 0; i < chains.size(); ++i)
+            {
+                auto first = i * FXChain::maxChannels;
+                chains[i]->process(buffer.getArrayOfWritePointers() + first, chains[i]->getNumChannels(), numSamples);
+            }
+        }
+        processTicks += Time::getHighResolutionTicks() - blockStart;
+
+        Trace::begin("write");
+        writer->writeFromAudioSampleBuffer(buffer, 0, numSamples);
+        Trace::end("write");
+        position = end;
+    }
+
+    writer.reset();
+
+    if(settings.stats)
+    {
+        for(int i = 0; i < chains.size(); ++i)
+        {
+            auto first = i * FXChain::maxChannels;
+
+            if(chains.size() > 1)
+            {
+                result.timings << "channels " << first + 1 << "-" << first + chains[i]->getNumChannels() << "\n";
+            }
+
+            result.timings << String(chains[i]->getTimings().format());
+        }
+    }
+
+    result.ok = true;
+    result.numSamples = reader->lengthInSamples;
+    result.numChannels = numChannels;
+    result.sampleRate = reader->sampleRate;
+    result.processSeconds = Time::highResolutionTicksToSeconds(processTicks);
+    result.totalSeconds = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - startTicks);
+
+    return result;
+}
+
+//==============================================================================
+class RenderJob : public ThreadPoolJob
+{
+public:
+    RenderJob(const File& in, const File& out, const RenderSettings& s)
+    : ThreadPoolJob(in.getFileName())
+    , input(in)
+    , output(out)
+    , settings(s)
+    {}
+
+    JobStatus runJob() override
+    {
+        Trace::setThreadName("render worker");
+        TraceScope scope("render file");
+
+        result = renderFile(input, output, settings);
+        return jobHasFinished;
+    }
+
+    RenderResult result;
+
+private:
+    File input, output;
+    const RenderSettings& settings;
+};
+
+static void printResult(const RenderResult& r)
+{
+    if(!r.ok)
+    {
+        fprintf(stderr, "%s: %s\n", r.input.getFileName().toRawUTF8(), r.error.toRawUTF8());
+        return;
+    }
+
+    auto audioSeconds = r.numSamples / r.sampleRate;
+    auto samplesPerSecond = r.processSeconds > 0 ? r.numSamples * r.numChannels / r.processSeconds : 0.0;
+
+    printf("%s: %lld samples x %d ch @ %.0f Hz, dsp %.3f s (%.3g samples/s, %.1fx real time), total %.3f s\n",
+        r.input.getFileName().toRawUTF8(),
+        static_cast<long long>(r.numSamples),
+        r.numChannels,
+        r.sampleRate,
+        r.processSeconds,
+        samplesPerSecond,
+        r.processSeconds > 0 ? audioSeconds / r.processSeconds : 0.0,
+        r.totalSeconds);
+
+    if(r.timings.isNotEmpty())
+    {
+        printf("%s", r.timings.toRawUTF8());
+    }
+}
+
+// false if the chain did anything on any file that it mustn't in the audio callback, which only a checking build counts
+static bool checkRealtime()
+{
+    auto violations = RealtimeCheck::getViolations();
+
+    if(violations > 0)
+    {
+        fprintf(stderr, "%u real-time violations in the chain\n", static_cast<unsigned>(violations));
+    }
+
+    return violations == 0;
+}
+
+static int usage()
+{
+    fprintf(stderr, "usage: OfflineRender [--settings file.json] [--block-size n] [--jobs n] [--stats] [--trace file.json] input output\n");
+    return 1;
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    ArgumentList args(argc, argv);
+
+    RenderSettings settings;
+    int numJobs = SystemStats::getNumCpus();
+
+    if(args.containsOption("--settings"))
+    {
+        String error;
+        if(!loadSettings(args.getExistingFileForOption("--settings"), settings, error))
+        {
+            fprintf(stderr, "%s\n", error.toRawUTF8());
+            return 1;
+        }
+    }
+
+    if(args.containsOption("--block-size"))
+    {
+        settings.blockSize = jmax(1, args.getValueForOption("--block-size").getIntValue());
+    }
+
+    settings.stats = args.containsOption("--stats");
+
+    if(args.containsOption("--jobs"))
+    {
+        numJobs = jmax(1, args.getValueForOption("--jobs").getIntValue());
+    }
+
+    // stopped however main returns, so the file always ends up complete
+    struct TraceStopper
+    {
+        ~TraceStopper() { Trace::stop(); }
+    } traceStopper;
+
+    if(args.containsOption("--trace"))
+    {
+        auto traceFile = File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--trace"));
+
+        if(!Trace::start(traceFile.getFullPathName().toRawUTF8()))
+        {
+            fprintf(stderr, "can't write trace to %s\n", traceFile.getFullPathName().toRawUTF8());
+            return 1;
+        }
+
+        Trace::setThreadName("main");
+    }
+
+    // whatever is left after the options is input and output
+    StringArray paths;
+    for(int i = 0; i < args.size(); ++i)
+    {
+        auto& arg = args[i];
+        if(arg.isOption())
+        {
+            // --stats is just a flag, the rest have a value
+            if(!arg.text.contains("=") && arg.text != "--stats")
+            {
+                ++i; // skip the option's value
+            }
+            continue;
+        }
+        paths.add(arg.text);
+    }
+
+    if(paths.size() != 2)
+    {
+        return usage();
+    }
+
+    File input = File::getCurrentWorkingDirectory().getChildFile(paths[0]);
+    File output = File::getCurrentWorkingDirectory().getChildFile(paths[1]);
+
+    if(input.existsAsFile())
+    {
+        Trace::begin("render file");
+        auto result = renderFile(input, output, settings);
+        Trace::end("render file");
+        printResult(result);
+        return checkRealtime() && result.ok ? 0 : 1;
+    }
+
+    if(!input.isDirectory())
+    {
+        fprintf(stderr, "%s does not exist\n", input.getFullPathName().toRawUTF8());
+        return 1;
+    }
+
+    output.createDirectory();
+
+    auto files = input.findChildFiles(File::findFiles, false, "*.wav;*.aif;*.aiff");
+    files.sort();
+
+    ThreadPool pool(numJobs);
+    OwnedArray<RenderJob> jobs;
+
+    auto startTicks = Time::getHighResolutionTicks();
+
+    for(auto& file : files)
+    {
+        auto* job = jobs.add(new RenderJob(file, output.getChildFile(file.getFileName()), settings));
+        pool.addJob(job, false);
+    }
+
+    for(auto* job : jobs)
+    {
+        while(pool.contains(job))
+        {
+            pool.waitForJobToFinish(job, 1000);
+        }
+    }
+
+    auto wallSeconds = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - startTicks);
+
+    int failures = 0;
+    double audioSeconds = 0;
+    int64 totalSamples = 0;
+
+    for(auto* job : jobs)
+    {
+        printResult(job->result);
+
+        if(!job->result.ok)
+        {
+            ++failures;
+            continue;
+        }
+
+        audioSeconds += job->result.numSamples / job->result.sampleRate;
+        totalSamples += job->result.numSamples * job->result.numChannels;
+    }
+
+    printf("%d files on %d threads in %.3f s (%.3g samples/s, %.1fx real time)\n",
+        files.size(),
+        numJobs,
+        wallSeconds,
+        wallSeconds > 0 ? totalSamples / wallSeconds : 0.0,
+        wallSeconds > 0 ? audioSeconds / wallSeconds : 0.0);
+
+    return checkRealtime() && failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,216 @@
+/*
+ * SendControl
+ *
+ * Drives the pedal from a host over USB serial the way the control board
+ * does, with the binary frames from Source/Control/ControlProtocol.h:
+ *
+ *     SendControl --port /dev/ttyUSB0 odVol=0.25 distDrive=0.8 delayMS=350
+ *
+ * Parameter names are the FXParameters members, as in OfflineRender's
+ * settings, or plain FXParameterID numbers. All of them go in one frame
+ * (several if there are more than ControlProtocol::maxEntries), so they
+ * land on the same block. The values are absolute and the pedal clamps them
+ * to each parameter's range.
+ *
+ * usage: SendControl [--port device] [--baud n] [--hex] name=value [name=value ...]
+ *
+ * --baud is 9600 unless given, the pedal's rate. Without --port the frames
+ * go to stdout, or with --hex a line of hex per frame for reading or pasting
+ * into a serial terminal.
+ */
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../../../Source/Control/ControlProtocol.h"
+#include "../../../Source/DSP/FXParameters.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <termios.h>
+#include <unistd.h>
+
+// a member name or an FXParameterID number, -1 if it's neither
+static int findParameter(const String& name)
+{
+    for(int id = 0; id < NUM_PARAMETERS; ++id)
+    {
+        if(name == FXParameters::getName(static_cast<FXParameterID>(id)))
+        {
+            return id;
+        }
+    }
+
+    if(name.containsOnly("0123456789") && name.isNotEmpty() && name.getIntValue() < NUM_PARAMETERS)
+    {
+        return name.getIntValue();
+    }
+
+    return -1;
+}
+
+static speed_t toSpeed(int baud)
+{
+    switch(baud)
+    {
+        case 9600:      return B9600;
+        case 19200:     return B19200;
+        case 38400:     return B38400;
+        case 57600:     return B57600;
+        case 115200:    return B115200;
+        default:        return B0;
+    }
+}
+
+// raw 8N1 at the given rate, -1 with the reason printed if it can't be had
+static int openPort(const String& device, int baud)
+{
+    const speed_t speed = toSpeed(baud);
+    if(speed == B0)
+    {
+        fprintf(stderr, "unsupported baud rate %d\n", baud);
+        return -1;
+    }
+
+    const int fd = open(device.toRawUTF8(), O_WRONLY | O_NOCTTY);
+    if(fd < 0)
+    {
+        fprintf(stderr, "can't open %s\n", device.toRawUTF8());
+        return -1;
+    }
+
+    termios settings;
+    if(tcgetattr(fd, &settings) != 0)
+    {
+        fprintf(stderr, "%s is not a serial port\n", device.toRawUTF8());
+        close(fd);
+        return -1;
+    }
+
+    cfmakeraw(&settings);
+    cfsetispeed(&settings, speed);
+    cfsetospeed(&settings, speed);
+    settings.c_cflag |= CLOCAL;
+
+    if(tcsetattr(fd, TCSANOW, &settings) != 0)
+    {
+        fprintf(stderr, "can't set up %s\n", device.toRawUTF8());
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static bool writeAll(int fd, const uint8_t* data, int size)
+{
+    while(size > 0)
+    {
+        const auto written = write(fd, data, static_cast<size_t>(size));
+        if(written <= 0)
+        {
+            return false;
+        }
+
+        data += written;
+        size -= static_cast<int>(written);
+    }
+
+    return true;
+}
+
+static int usage()
+{
+    fprintf(stderr, "usage: SendControl [--port device] [--baud n] [--hex] name=value [name=value ...]\n");
+    return 1;
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    ArgumentList args(argc, argv);
+
+    const bool hex = args.containsOption("--hex");
+    const int baud = args.containsOption("--baud") ? args.getValueForOption("--baud").getIntValue() : 9600;
+    const String port = args.getValueForOption("--port");
+
+    // whatever is left after the options is the settings, each frame holds as many as fit
+    ControlFrameEncoder encoder;
+    Array<ControlFrameEncoder> frames;
+
+    for(int i = 0; i < args.size(); ++i)
+    {
+        const String arg = args[i].text;
+
+        // --port and --baud take the next argument unless they're written --port=device
+        if(arg.startsWith("--"))
+        {
+            if(arg != "--hex" && !arg.contains("="))
+            {
+                ++i;
+            }
+
+            continue;
+        }
+
+        if(!arg.contains("="))
+        {
+            return usage();
+        }
+
+        const String name = arg.upToFirstOccurrenceOf("=", false, false);
+        const int id = findParameter(name);
+
+        if(id < 0)
+        {
+            fprintf(stderr, "unknown parameter %s\n", name.toRawUTF8());
+            return 1;
+        }
+
+        if(encoder.getNumEntries() == ControlProtocol::maxEntries)
+        {
+            frames.add(encoder);
+            encoder.clear();
+        }
+
+        encoder.add(static_cast<uint8_t>(id), arg.fromFirstOccurrenceOf("=", false, false).getFloatValue());
+    }
+
+    if(encoder.getNumEntries() == 0)
+    {
+        return usage();
+    }
+
+    frames.add(encoder);
+
+    const int fd = port.isNotEmpty() ? openPort(port, baud) : STDOUT_FILENO;
+    if(fd < 0)
+    {
+        return 1;
+    }
+
+    for(auto& frame : frames)
+    {
+        const uint8_t* data = frame.getData();
+        const int size = frame.getSize();
+
+        if(hex && port.isEmpty())
+        {
+            printf("%s\n", String::toHexString(data, size).toRawUTF8());
+            continue;
+        }
+
+        if(!writeAll(fd, data, size))
+        {
+            fprintf(stderr, "can't write to %s\n", port.isNotEmpty() ? port.toRawUTF8() : "stdout");
+            return 1;
+        }
+    }
+
+    // wait for the bytes to leave, closing may throw away what's still queued
+    if(port.isNotEmpty())
+    {
+        tcdrain(fd);
+        close(fd);
+    }
+
+    return 0;
+}